@@ -0,0 +1,73 @@
+#include "buddy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BLOCK_SIZE 1024
+#define NUM_BLOCKS 1024     // 1MB pool / 1KB blocks
+#define NUM_OPS 200000
+
+// Returns the current monotonic time in nanoseconds
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Random free/alloc churn of 1KB blocks with the pool kept at `occupancy` percent
+static void bench_churn(int occupancy) {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+
+    void* blocks[NUM_BLOCKS];
+    int live = NUM_BLOCKS * occupancy / 100;
+    for (int i = 0; i < live; i++) {
+        blocks[i] = buddy_alloc(&buddy, BLOCK_SIZE);
+        if (blocks[i] == NULL) {
+            fprintf(stderr, "Failed to prefill pool\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    srand(42);
+    uint64_t start = now_ns();
+    for (int op = 0; op < NUM_OPS; op++) {
+        int victim = rand() % live;
+        buddy_free(&buddy, blocks[victim]);
+        blocks[victim] = buddy_alloc(&buddy, BLOCK_SIZE);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("occupancy %3d%%: %7.1f ns per alloc+free\n",
+           occupancy, (double)elapsed / NUM_OPS);
+}
+
+// Repeated alloc/free of one block of `size` bytes
+static void bench_same_size(uint32_t size) {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+
+    uint64_t start = now_ns();
+    for (int op = 0; op < NUM_OPS; op++) {
+        void* block = buddy_alloc(&buddy, size);
+        buddy_free(&buddy, block);
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("same size %7u: %7.1f ns per alloc+free\n",
+           size, (double)elapsed / NUM_OPS);
+}
+
+int main() {
+    int occupancies[] = {25, 50, 75, 90, 99};
+    int num_occupancies = sizeof(occupancies) / sizeof(occupancies[0]);
+
+    printf("Buddy allocator churn benchmark (%d ops, %d-byte blocks)\n", NUM_OPS, BLOCK_SIZE);
+    for (int i = 0; i < num_occupancies; i++) {
+        bench_churn(occupancies[i]);
+    }
+    bench_same_size(1024);
+    bench_same_size(64 * 1024);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "allocator.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_OBJECTS 256
+#define NUM_WALKS 4000
+#define NUM_THREADS 4
+#define NUM_INCREMENTS 20000000
+
+// Returns the current monotonic time in nanoseconds
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Walks a linked list threaded through the first line of NUM_OBJECTS objects
+static void bench_walk(const char* name, unsigned int flags) {
+    void** objects[NUM_OBJECTS];
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        objects[i] = my_malloc_hint(64, flags, 0);
+    }
+    for (int i = 0; i < NUM_OBJECTS; i++) {
+        *objects[i] = objects[(i * 7 + 1) % NUM_OBJECTS]; // Not sequential, 7 is coprime
+    }
+
+    void** cursor = objects[0];
+    uint64_t start = now_ns();
+    for (int walk = 0; walk < NUM_WALKS * NUM_OBJECTS; walk++) {
+        cursor = *cursor;
+    }
+    uint64_t elapsed = now_ns() - start;
+    printf("%-24s %6.2f ns per object visit (%p)\n", name,
+           (double)elapsed / (NUM_WALKS * NUM_OBJECTS), (void*)cursor);
+
+    for (int i = 0; i < NUM_OBJECTS; i++) my_free(objects[i]);
+}
+
+// Increments a thread's own counter
+static void* count(void* arg) {
+    volatile uint64_t* counter = arg;
+    for (int i = 0; i < NUM_INCREMENTS; i++) (*counter)++;
+    return NULL;
+}
+
+// Runs NUM_THREADS threads, each bumping the counter it was handed
+static void bench_counters(const char* name, volatile uint64_t** counters) {
+    pthread_t threads[NUM_THREADS];
+    uint64_t start = now_ns();
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_create(&threads[i], NULL, count, (void*)counters[i]);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) pthread_join(threads[i], NULL);
+    uint64_t elapsed = now_ns() - start;
+    printf("%-24s %6.2f ns per increment\n", name,
+           (double)elapsed / ((uint64_t)NUM_THREADS * NUM_INCREMENTS));
+}
+
+int main() {
+    printf("Set aliasing: pointer walk over %d small objects\n", NUM_OBJECTS);
+    bench_walk("plain my_malloc", 0);
+    bench_walk("MALLOC_COLORED", MALLOC_COLORED);
+
+    // The allocator is not thread-safe: allocate everything up front
+    printf("Per-thread counters (%d threads)\n", NUM_THREADS);
+    volatile uint64_t* counters[NUM_THREADS];
+    uint64_t* packed = my_malloc(NUM_THREADS * sizeof(uint64_t));
+    memset(packed, 0, NUM_THREADS * sizeof(uint64_t));
+    for (int i = 0; i < NUM_THREADS; i++) counters[i] = &packed[i];
+    bench_counters("packed in one line", counters);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        counters[i] = my_malloc_hint(sizeof(uint64_t), MALLOC_THREAD_OWNED | MALLOC_ZEROED, 0);
+    }
+    bench_counters("MALLOC_THREAD_OWNED", counters);
+
+    for (int i = 0; i < NUM_THREADS; i++) my_free((void*)counters[i]);
+    my_free(packed);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "buddy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define NUM_STEPS 400000
+#define MAX_LIVE 2048
+#define PROBE_EVERY 1000
+
+// Random size between 1KB and 64KB, skewed towards small blocks
+static uint32_t random_size() {
+    uint32_t shift = rand() % 7;                 // 1KB .. 64KB class
+    uint32_t base = 1024u << shift;
+    return base / 2 + 1 + rand() % (base / 2);   // Upper half of the class
+}
+
+// Returns the largest block size the allocator can still hand out
+static uint32_t largest_block(BuddyAllocator* buddy) {
+    for (uint32_t size = 1048576; size >= 1024; size >>= 1) {
+        void* block = buddy_alloc(buddy, size);
+        if (block != NULL) {
+            buddy_free(buddy, block);
+            buddy_flush(buddy);
+            return size;
+        }
+    }
+    return 0;
+}
+
+// Random alloc/free workload; every free is flushed so each allocation
+// goes through the policy instead of the quick lists
+static void bench_policy(const char* name, uint32_t policy, uint64_t target_live_bytes) {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+    buddy_set_policy(&buddy, policy);
+
+    void* blocks[MAX_LIVE];
+    uint32_t sizes[MAX_LIVE];
+    int live = 0;
+    uint64_t live_bytes = 0;
+    uint64_t attempts = 0, failures = 0;
+    uint64_t largest_sum = 0, probes = 0;
+
+    srand(1234);
+    for (int step = 0; step < NUM_STEPS; step++) {
+        int do_alloc = live == 0 ||
+                       (live < MAX_LIVE && live_bytes < target_live_bytes && rand() % 4 != 0);
+        if (do_alloc) {
+            uint32_t size = random_size();
+            attempts++;
+            void* block = buddy_alloc(&buddy, size);
+            if (block == NULL) {
+                failures++;
+            } else {
+                blocks[live] = block;
+                sizes[live] = size;
+                live++;
+                live_bytes += size;
+            }
+        } else {
+            int victim = rand() % live;
+            buddy_free(&buddy, blocks[victim]);
+            buddy_flush(&buddy);
+            live_bytes -= sizes[victim];
+            live--;
+            blocks[victim] = blocks[live];
+            sizes[victim] = sizes[live];
+        }
+
+        if (step % PROBE_EVERY == 0) {
+            largest_sum += largest_block(&buddy);
+            probes++;
+        }
+    }
+
+    printf("%-10s failure rate %5.2f%%   mean largest allocatable block %6.1f KB\n",
+           name, 100.0 * failures / attempts, (double)largest_sum / probes / 1024);
+}
+
+int main() {
+    // Requested bytes kept live in the 1MB pool (rounding adds ~1/3 on top)
+    uint64_t targets[] = {400 * 1024, 550 * 1024, 700 * 1024};
+    int num_targets = sizeof(targets) / sizeof(targets[0]);
+
+    for (int i = 0; i < num_targets; i++) {
+        printf("Fragmentation benchmark (%d steps, ~%llu KB requested live)\n",
+               NUM_STEPS, (unsigned long long)(targets[i] / 1024));
+        bench_policy("smallest", BUDDY_POLICY_SMALLEST, targets[i]);
+        bench_policy("best-fit", BUDDY_POLICY_BEST_FIT, targets[i]);
+        bench_policy("address", BUDDY_POLICY_ADDRESS, targets[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "buddy.h"
+#include "nodemap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Counts the node-map cache lines each buddy_alloc / buddy_free touches.
+// Linked with --wrap=nodemap_get,--wrap=nodemap_set, so every node access
+// made by buddy.c is recorded and scored under two layouts: the blocked one
+// in use, and plain heap order (node i in byte i / 4) with the same 2-bit states.
+
+#define CACHE_LINE_SIZE 64
+#define BLOCK_SIZE 1024
+#define NUM_BLOCKS 1024     // 1MB pool / 1KB blocks
+#define NUM_OPS 200000
+
+uint8_t __real_nodemap_get(const NodeMap* nm, uint32_t index);
+void __real_nodemap_set(NodeMap* nm, uint32_t index, uint8_t state);
+
+// Lines touched by the current operation (576-byte map = 9 lines, 1 bit each)
+static uint32_t blocked_lines;
+static uint32_t heap_lines;
+
+static void record(const NodeMap* nm, uint32_t index) {
+    blocked_lines |= 1u << (nodemap_byte(nm, index) / CACHE_LINE_SIZE);
+    heap_lines |= 1u << (index / 4 / CACHE_LINE_SIZE);
+}
+
+uint8_t __wrap_nodemap_get(const NodeMap* nm, uint32_t index) {
+    record(nm, index);
+    return __real_nodemap_get(nm, index);
+}
+
+void __wrap_nodemap_set(NodeMap* nm, uint32_t index, uint8_t state) {
+    record(nm, index);
+    __real_nodemap_set(nm, index, state);
+}
+
+// Line counts of the operations that reached the tree (quick-list hits do not)
+typedef struct {
+    uint64_t ops;
+    uint64_t blocked_total;
+    uint64_t heap_total;
+    int blocked_max;
+    int heap_max;
+} LineStats;
+
+static void start_op() {
+    blocked_lines = 0;
+    heap_lines = 0;
+}
+
+static void end_op(LineStats* stats) {
+    if (blocked_lines == 0) return;
+    int blocked = __builtin_popcount(blocked_lines);
+    int heap = __builtin_popcount(heap_lines);
+    stats->ops++;
+    stats->blocked_total += blocked;
+    stats->heap_total += heap;
+    if (blocked > stats->blocked_max) stats->blocked_max = blocked;
+    if (heap > stats->heap_max) stats->heap_max = heap;
+}
+
+static void print_stats(const char* name, const LineStats* stats) {
+    if (stats->ops == 0) return;
+    printf("  %-6s %7llu tree ops: blocked %.2f lines (max %d), heap order %.2f lines (max %d)\n",
+           name, (unsigned long long)stats->ops,
+           (double)stats->blocked_total / stats->ops, stats->blocked_max,
+           (double)stats->heap_total / stats->ops, stats->heap_max);
+}
+
+// Same churn as bench_buddy: random 1KB frees and allocs at `occupancy` percent.
+// With `tree_only`, every free is flushed so both operations walk the tree.
+static void bench_churn(int occupancy, int tree_only) {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+
+    void* blocks[NUM_BLOCKS];
+    int live = NUM_BLOCKS * occupancy / 100;
+    for (int i = 0; i < live; i++) {
+        blocks[i] = buddy_alloc(&buddy, BLOCK_SIZE);
+        if (blocks[i] == NULL) {
+            fprintf(stderr, "Failed to prefill pool\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    LineStats alloc_stats = {0}, free_stats = {0};
+    srand(42);
+    for (int op = 0; op < NUM_OPS; op++) {
+        int victim = rand() % live;
+        start_op();
+        buddy_free(&buddy, blocks[victim]);
+        if (tree_only) buddy_flush(&buddy);
+        end_op(&free_stats);
+        start_op();
+        blocks[victim] = buddy_alloc(&buddy, BLOCK_SIZE);
+        end_op(&alloc_stats);
+    }
+
+    printf("occupancy %3d%%%s:\n", occupancy, tree_only ? ", quick lists flushed" : "");
+    print_stats("alloc", &alloc_stats);
+    print_stats("free", &free_stats);
+}
+
+int main() {
+    int occupancies[] = {25, 50, 75, 90, 99};
+    int num_occupancies = sizeof(occupancies) / sizeof(occupancies[0]);
+
+    printf("Node-map cache lines per buddy operation (%d ops, %d-byte blocks)\n", NUM_OPS, BLOCK_SIZE);
+    for (int i = 0; i < num_occupancies; i++) {
+        bench_churn(occupancies[i], 0);
+    }
+    for (int i = 0; i < num_occupancies; i++) {
+        bench_churn(occupancies[i], 1);
+    }
+    return 0;
+}
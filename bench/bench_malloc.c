@@ -0,0 +1,104 @@
+#include "allocator.h"
+#include "allocator_inline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define NUM_OPS 2000000
+#define BATCH 16
+// Interleaved rounds per guard sampling configuration
+#define GUARD_ROUNDS 11
+
+// Returns the current monotonic time in nanoseconds
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Allocates and frees `ops` 64-byte blocks in batches through my_malloc/my_free.
+// Every batch is freed, so each call leaves the heap as it found it.
+// Returns the time per alloc+free in nanoseconds.
+static double run_out_of_line(int ops) {
+    void* ptrs[BATCH];
+    uint64_t start = now_ns();
+    for (int op = 0; op < ops; op += BATCH) {
+        for (int i = 0; i < BATCH; i++) ptrs[i] = my_malloc(64);
+        for (int i = 0; i < BATCH; i++) my_free(ptrs[i]);
+    }
+    return (double)(now_ns() - start) / ops;
+}
+
+static void bench_out_of_line(const char* name) {
+    printf("%-32s %6.1f ns per alloc+free\n", name, run_out_of_line(NUM_OPS));
+}
+
+// Same workload through the inline fast path
+static void bench_inline() {
+    void* ptrs[BATCH];
+    uint64_t start = now_ns();
+    for (int op = 0; op < NUM_OPS; op += BATCH) {
+        for (int i = 0; i < BATCH; i++) ptrs[i] = my_malloc_inline(64);
+        for (int i = 0; i < BATCH; i++) my_free_inline(ptrs[i]);
+    }
+    uint64_t elapsed = now_ns() - start;
+    printf("%-32s %6.1f ns per alloc+free\n", "my_malloc_inline/my_free_inline:", (double)elapsed / NUM_OPS);
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Overhead of sampled guard pages on the regular path. The configurations
+// take turns round by round (in a rotating order) on the same heap, so drift
+// in machine or heap state hits all of them alike; medians are reported.
+static void bench_guard_overhead() {
+    unsigned int rates[] = {0, 5000, 1000};
+    int num_rates = sizeof(rates) / sizeof(rates[0]);
+    int ops = NUM_OPS / 4;
+    double times[3][GUARD_ROUNDS];
+
+    run_out_of_line(ops); // Warm up
+    for (int round = 0; round < GUARD_ROUNDS; round++) {
+        for (int k = 0; k < num_rates; k++) {
+            int r = (round + k) % num_rates;
+            my_malloc_guard_enable(rates[r]);
+            times[r][round] = run_out_of_line(ops);
+        }
+    }
+    my_malloc_guard_enable(0);
+
+    // The guarded path itself: every allocation sampled (a batch fits in the slots)
+    my_malloc_guard_enable(1);
+    double guarded = run_out_of_line(BATCH * 1000);
+    my_malloc_guard_enable(0);
+    printf("%-32s %6.1f ns per alloc+free\n", "guarded alloc+free:", guarded);
+
+    // Measured overhead, and the one expected from the guarded path's cost
+    double median[3];
+    for (int r = 0; r < num_rates; r++) {
+        qsort(times[r], GUARD_ROUNDS, sizeof(double), compare_double);
+        median[r] = times[r][GUARD_ROUNDS / 2];
+    }
+    printf("%-32s %6.1f ns per alloc+free (median of %d)\n",
+           "guard sampling off:", median[0], GUARD_ROUNDS);
+    for (int r = 1; r < num_rates; r++) {
+        char name[32];
+        snprintf(name, sizeof(name), "guard sampling 1/%u:", rates[r]);
+        printf("%-32s %6.1f ns per alloc+free (%+.1f%%, expected %+.1f%%)\n", name, median[r],
+               100.0 * (median[r] - median[0]) / median[0],
+               100.0 * guarded / rates[r] / median[0]);
+    }
+}
+
+int main() {
+    printf("Small allocation fast path benchmark (%d ops, batches of %d)\n", NUM_OPS, BATCH);
+    bench_out_of_line("my_malloc/my_free:");
+    bench_inline();
+
+    bench_guard_overhead();
+    my_malloc_thread_flush();
+    return 0;
+}
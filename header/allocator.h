@@ -3,7 +3,49 @@
 
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Allocation hints for my_malloc_hint
+#define MALLOC_SHORT_LIVED 0x1  // Freed soon (default arena)
+#define MALLOC_LONG_LIVED  0x2  // Kept around: separate arena so it does not pin short-lived space
+#define MALLOC_ZEROED      0x4  // Return zero-filled memory
+#define MALLOC_NO_DUMP     0x8  // Exclude the memory from core dumps
+#define MALLOC_COLORED     0x10 // Small: rotate the start offset by cache lines to spread cache sets
+#define MALLOC_THREAD_OWNED 0x20 // Used by one thread: 128B aligned, no line pair shared with other allocations
+
+// Reservation flags for my_malloc_reserve
+#define MALLOC_RESERVE_POPULATE 0x1  // Prefault reserved memory and future large mappings
+#define MALLOC_RESERVE_LOCK     0x2  // mlock the reserved small-object heap
+
+// Number of arena pairs (short-/long-lived) shared by the locality groups
+#define MALLOC_GROUP_ARENAS 4
+
 void* my_malloc(size_t size);
+// Like my_malloc, with MALLOC_* flags and a locality group (0 = none).
+// Small allocations go to an arena chosen by placement (MALLOC_NO_DUMP, else
+// the group, else the default arena) and, within it, by lifetime class:
+// long- and short-lived objects never share an arena, even in one group.
+void* my_malloc_hint(size_t size, unsigned int flags, unsigned int group);
+// Free a pointer returned by my_malloc / my_malloc_hint. Any other pointer
+// into a small block (not the start of its object) is ignored.
 void my_free(void* ptr);
+// Eagerly create the default and long-lived small-object arenas and apply
+// MALLOC_RESERVE_* to `bytes` bytes in total: the default arena's 1MB first,
+// then the long-lived one's. No-dump and group arenas are created on first use
+// and never reserved. Returns 0 on success, -1 if the memory could not be locked.
+// Also run at startup from MY_MALLOC_RESERVE=<bytes> and
+// MY_MALLOC_RESERVE_FLAGS=populate,lock.
+int my_malloc_reserve(size_t bytes, unsigned int flags);
+// Route about 1 in `sample_rate` allocations of up to a page to guard-paged
+// slots that report overflows and use-after-free on stderr (0 = off).
+// MALLOC_COLORED, MALLOC_THREAD_OWNED and MALLOC_NO_DUMP requests are not sampled.
+// Also enabled at startup from MY_MALLOC_GUARD_RATE=<sample_rate>.
+void my_malloc_guard_enable(unsigned int sample_rate);
+
+#ifdef __cplusplus
+}
+#endif
 
-#endif
\ No newline at end of file
+#endif
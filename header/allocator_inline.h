@@ -0,0 +1,86 @@
+#ifndef ALLOCATOR_INLINE_H
+#define ALLOCATOR_INLINE_H
+
+#include "allocator.h"
+#include <stdint.h>
+
+// Threshold between small and large allocations (1/4 page, see allocator.c)
+#define MALLOC_SMALL_THRESHOLD 1024
+// Size of a small block (the buddy allocator's 1KB minimum block)
+#define MALLOC_SMALL_BLOCK_SIZE 1024
+// Size of the buddy pool of the default arena (1MB)
+#define MALLOC_SMALL_POOL_SIZE (1024 * 1024)
+// Maximum number of free small blocks cached per thread
+#define MALLOC_TCACHE_SIZE 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-thread cache of free small blocks of the default arena
+typedef struct {
+    void* blocks[MALLOC_TCACHE_SIZE];
+    uint32_t count;
+    uint32_t registered; // Thread-exit flush registered (see my_malloc_thread_register)
+} MallocTCache;
+
+extern __thread MallocTCache malloc_tcache;
+// Start of the default arena's pool (0 until it is created)
+extern uintptr_t malloc_small_base;
+
+// Return the calling thread's cached blocks to the allocator
+void my_malloc_thread_flush(void);
+// Arrange for my_malloc_thread_flush to run when the calling thread exits.
+// my_free_inline calls it the first time it fills the cache, so cached blocks
+// are not leaked by exiting threads.
+void my_malloc_thread_register(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Inline my_malloc: small requests pop from the thread cache, anything
+// else falls back to my_malloc. Constant sizes resolve the class at compile time.
+// Cache hits skip guard-page sampling (see my_malloc_guard_enable).
+static inline void* my_malloc_inline(size_t size) {
+    if (__builtin_constant_p(size) && (size == 0 || size >= MALLOC_SMALL_THRESHOLD)) {
+        return my_malloc(size);
+    }
+    if (size - 1 < MALLOC_SMALL_THRESHOLD - 1 && malloc_tcache.count > 0) {
+        return malloc_tcache.blocks[--malloc_tcache.count];
+    }
+    return my_malloc(size);
+}
+
+// Inline my_free: small blocks of the default arena go to the thread cache.
+// Pointers inside a block (colored objects, stray pointers) are left to my_free.
+// Unlike my_free, double frees are not detected on this path.
+static inline void my_free_inline(void* ptr) {
+    if (ptr != NULL && (uintptr_t)ptr - malloc_small_base < MALLOC_SMALL_POOL_SIZE &&
+        (uintptr_t)ptr % MALLOC_SMALL_BLOCK_SIZE == 0 && malloc_tcache.count < MALLOC_TCACHE_SIZE) {
+        if (!malloc_tcache.registered) my_malloc_thread_register();
+        malloc_tcache.blocks[malloc_tcache.count++] = ptr;
+        return;
+    }
+    my_free(ptr);
+}
+
+#ifdef __cplusplus
+// Allocate `Size` bytes with the size class chosen at compile time
+template <size_t Size>
+static inline void* my_malloc_sized() {
+    static_assert(Size > 0, "my_malloc_sized needs a non-zero size");
+    if constexpr (Size < MALLOC_SMALL_THRESHOLD) {
+        if (malloc_tcache.count > 0) return malloc_tcache.blocks[--malloc_tcache.count];
+    }
+    return my_malloc(Size);
+}
+
+// Raw storage for one T (no constructor is run)
+template <typename T>
+static inline T* my_malloc_for() {
+    return static_cast<T*>(my_malloc_sized<sizeof(T)>());
+}
+#endif
+
+#endif
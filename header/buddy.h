@@ -1,23 +1,95 @@
 #ifndef BUDDY_H
 #define BUDDY_H
 
-#include "bitmap.h"
+#include "nodemap.h"
+
+#include <pthread.h>
+
+// Number of tree levels (0 = 1MB, 10 = 1KB)
+#define BUDDY_LEVELS 11
+// Maximum number of freed blocks cached per level before coalescing
+#define BUDDY_QUICK_LIST_SIZE 8
+
+// Block selection policies (see buddy_set_policy)
+#define BUDDY_POLICY_SMALLEST 0     // Smallest sufficient free block, lowest address first (default)
+#define BUDDY_POLICY_BEST_FIT 1     // Like SMALLEST, preferring blocks whose buddy is fully used
+#define BUDDY_POLICY_ADDRESS  2     // Lowest-address free block that is large enough
+
+// Number of root offsets kept in a file-backed heap
+#define BUDDY_FILE_ROOTS 8
+
+// Header at the start of a file-backed heap (offsets are relative to the pool)
+typedef struct {
+    uint64_t magic;             // BUDDY_FILE_MAGIC
+    uint32_t version;           // Layout version
+    uint32_t pool_size;         // 1MB
+    uint32_t nodes_size;        // Size of the node map in BYTES
+    uint32_t clean;             // 1 = detached cleanly, 0 = attached or crashed
+    uint64_t roots[BUDDY_FILE_ROOTS]; // Pool offset + 1 of each root (0 = NULL)
+} BuddyFileHeader;
+
+// Header at the start of a heap shared between processes
+typedef struct {
+    uint64_t magic;             // BUDDY_SHARED_MAGIC
+    uint32_t version;           // Layout version
+    uint32_t pool_size;         // 1MB
+    pthread_mutex_t lock;       // Process-shared, robust: guards the node map
+} BuddySharedHeader;
 
 // Buddy allocator managing a 1MB memory pool
 typedef struct {
     uint8_t* memory_pool;       // 1MB pool for small allocations
-    BitMap split_bits;          // Tracks split blocks (1 = split)
-    BitMap alloc_bits;          // Tracks allocated blocks (1 = allocated)
+    NodeMap nodes;              // Packed 2-bit state of every tree node
     uint32_t min_block_size;    // 1024 bytes (1KB)
+    uint32_t policy;            // BUDDY_POLICY_* used to pick free blocks
+    // Recently freed blocks per level (LIFO), still marked allocated in `nodes`
+    uint32_t quick_list[BUDDY_LEVELS][BUDDY_QUICK_LIST_SIZE];
+    uint32_t quick_count[BUDDY_LEVELS];
+    BuddyFileHeader* file_header; // Mapped file header (NULL if not file-backed)
+    int file_fd;                // Heap file, flock-ed until buddy_close (-1 if not file-backed)
+    BuddySharedHeader* shared_header; // Mapped shared header (NULL if not shared)
 } BuddyAllocator;
 
 // Initialize the buddy allocator with mmap-ed memory
 void buddy_init(BuddyAllocator* buddy);
 
+// Initialize the buddy allocator on a heap file shared with its previous
+// users: created if missing, reattached (and repaired after a crash) otherwise.
+// The file is locked until buddy_close, so only one allocator attaches it at a time.
+// Returns 0 on success, -1 on error (including when the file is in use).
+int buddy_init_file(BuddyAllocator* buddy, const char* path);
+// Write the heap back to its file
+int buddy_sync(BuddyAllocator* buddy);
+// Sync, mark the file clean and unmap it
+void buddy_close(BuddyAllocator* buddy);
+
+// Persistent root pointers of a file-backed heap (stored as offsets;
+// buddy_get_root returns NULL for an empty or out-of-range slot)
+void buddy_set_root(BuddyAllocator* buddy, uint32_t slot, void* ptr);
+void* buddy_get_root(const BuddyAllocator* buddy, uint32_t slot);
+
+// Create a heap in a new memfd shared with other processes.
+// Returns the fd to hand to them (by fork or SCM_RIGHTS), or -1 on error.
+int buddy_create_shared(BuddyAllocator* buddy);
+// Map a shared heap created by buddy_create_shared. Returns 0 on success, -1 on error.
+int buddy_attach_shared(BuddyAllocator* buddy, int fd);
+// Unmap a shared heap (blocks stay allocated for the other processes)
+void buddy_detach_shared(BuddyAllocator* buddy);
+
+// Process-independent handle of a block (pool offset) and back
+uint32_t buddy_to_offset(const BuddyAllocator* buddy, void* ptr);
+void* buddy_from_offset(const BuddyAllocator* buddy, uint32_t offset);
+
 // Allocate/free memory from the buddy system
 void* buddy_alloc(BuddyAllocator* buddy, uint32_t size);
 void buddy_free(BuddyAllocator* buddy, void* ptr);
 
+// Return every block held in the quick lists to the tree and coalesce
+void buddy_flush(BuddyAllocator* buddy);
+
+// Select how free blocks are picked (quick-list hits bypass the policy)
+void buddy_set_policy(BuddyAllocator* buddy, uint32_t policy);
+
 // Auxiliary functions
 uint32_t get_level(uint32_t block_size);
 int32_t find_free_block(BuddyAllocator* buddy, uint32_t level);
@@ -0,0 +1,52 @@
+#ifndef GUARD_H
+#define GUARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of guarded slots (each one page, surrounded by guard pages)
+#define GUARD_SLOTS 16
+// Size of a slot: largest sampled allocation
+#define GUARD_SLOT_SIZE 4096
+// Number of frames kept for allocation/free stacks
+#define GUARD_STACK_DEPTH 16
+
+// Slot states
+#define GUARD_SLOT_EMPTY 0
+#define GUARD_SLOT_LIVE  1
+#define GUARD_SLOT_FREED 2
+
+// One guarded allocation and where it came from
+typedef struct {
+    uint8_t* ptr;               // Object start (right-aligned against the next guard page)
+    size_t size;                // Requested size
+    int state;                  // GUARD_SLOT_*
+    int alloc_depth;            // Frames in alloc_stack
+    int free_depth;             // Frames in free_stack
+    void* alloc_stack[GUARD_STACK_DEPTH];
+    void* free_stack[GUARD_STACK_DEPTH];
+} GuardSlot;
+
+// Pool of guard-paged slots for sampled allocations
+typedef struct {
+    uint8_t* pool;              // Guard page, slot, guard page, slot, ..., guard page
+    size_t pool_size;           // Size of the pool in BYTES
+    uint32_t next_slot;         // Round-robin cursor, so freed slots stay protected longest
+    GuardSlot slots[GUARD_SLOTS];
+} GuardedPool;
+
+// Initialize the pool with mmap-ed, inaccessible memory
+void guard_init(GuardedPool* guard);
+
+// Allocate/free a guarded object (guard_alloc returns NULL if it cannot)
+void* guard_alloc(GuardedPool* guard, size_t size);
+void guard_free(GuardedPool* guard, void* ptr);
+
+// Returns 1 if `ptr` lies in the pool
+int guard_owns(const GuardedPool* guard, const void* ptr);
+
+// Describes an access to `addr` and the stacks of the slot it hit on `fd`.
+// Returns 0 if `addr` is not in the pool.
+int guard_report(const GuardedPool* guard, const void* addr, int fd);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef NODEMAP_H
+#define NODEMAP_H
+
+#include <stdint.h>
+
+// Per-node state of a buddy tree, packed in 2 bits
+#define NODE_FREE  0   // Whole subtree is free
+#define NODE_SPLIT 1   // Split, some free space left below
+#define NODE_FULL  2   // Split, no free space left below
+#define NODE_ALLOC 3   // Allocated as a single block
+
+// Number of tree levels kept together in the top block (255 nodes = 1 cache line)
+#define NODEMAP_TOP_LEVELS 8
+
+// Packed node-state array in blocked order: the top NODEMAP_TOP_LEVELS levels
+// are stored first, followed by each remaining subtree stored contiguously
+typedef struct {
+    uint8_t* buffer;        // Externally allocated buffer
+    uint32_t buffer_size;   // Size of the buffer in BYTES
+    uint32_t num_levels;    // Number of tree levels (root = level 0)
+    uint32_t num_nodes;     // Number of nodes tracked (2^levels - 1)
+} NodeMap;
+
+// Returns the number of bytes to store a tree of the given number of levels
+uint32_t NodeMap_getBytes(uint32_t num_levels);
+
+// Initialize the node map with a pre-allocated, zeroed buffer
+void nodemap_init(NodeMap* nm, uint8_t* buffer, uint32_t num_levels);
+
+// Node state operations (index is the heap-ordered node index)
+uint8_t nodemap_get(const NodeMap* nm, uint32_t index);
+void nodemap_set(NodeMap* nm, uint32_t index, uint8_t state);
+// Returns the byte of the buffer that holds the node's state
+uint32_t nodemap_byte(const NodeMap* nm, uint32_t index);
+
+#endif
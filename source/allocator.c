@@ -1,72 +1,335 @@
+#include "allocator.h"
+#include "allocator_inline.h"
+#include "bitmap.h"
 #include "buddy.h"
+#include "guard.h"
 #include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
 #include <sys/mman.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 // System page size (typically 4096 bytes)
 #define PAGE_SIZE 4096
 // Threshold between small and large allocations (1/4 page)
 #define SMALL_THRESHOLD (PAGE_SIZE / 4)
+// Cache line size, and the line pair fetched together by the spatial prefetcher
+#define CACHE_LINE_SIZE 64
+#define CACHE_LINE_PAIR_SIZE (2 * CACHE_LINE_SIZE)
 
-// Global buddy allocator instance
-static BuddyAllocator global_buddy;
-static int buddy_initialized = 0;
+// Buddy arenas for small allocations: every placement (default, no-dump,
+// locality group) has a short-lived and a long-lived arena next to each other
+enum {
+    ARENA_DEFAULT = 0,      // Short-lived and unhinted allocations
+    ARENA_LONG_LIVED,       // Long-lived allocations
+    ARENA_NO_DUMP,          // Excluded from core dumps (short-lived, then long-lived)
+    ARENA_GROUP = ARENA_NO_DUMP + 2, // First of MALLOC_GROUP_ARENAS locality arena pairs
+    NUM_ARENAS = ARENA_GROUP + 2 * MALLOC_GROUP_ARENAS
+};
 
-// Initialize buddy allocator once
-static void initialize_buddy() {
-    if (!buddy_initialized) {
-        buddy_init(&global_buddy);
-        buddy_initialized = 1;
+// Global buddy allocator instances
+static BuddyAllocator arenas[NUM_ARENAS];
+static int arena_initialized[NUM_ARENAS];
+// Next start-offset color of each arena (see color_block)
+static uint32_t arena_color[NUM_ARENAS];
+// Blocks of each arena whose object starts inside the block (1MB pool / 1KB blocks)
+#define ARENA_BLOCKS 1024
+static BitMap arena_colored[NUM_ARENAS];
+static uint8_t arena_colored_bits[NUM_ARENAS][ARENA_BLOCKS / 8];
+
+// Inline fast path state (see allocator_inline.h)
+__thread MallocTCache malloc_tcache;
+uintptr_t malloc_small_base;
+// Key whose destructor flushes an exiting thread's cache
+static pthread_key_t tcache_key;
+static pthread_once_t tcache_key_once = PTHREAD_ONCE_INIT;
+
+// Sampled guard-page mode (see my_malloc_guard_enable)
+static GuardedPool guarded_pool;
+static unsigned int guard_sample_rate;
+static __thread unsigned int guard_countdown;
+static struct sigaction previous_segv;
+
+// Reservation requested by my_malloc_reserve, and what each arena already has
+static unsigned int reserve_flags;
+static size_t reserve_bytes;
+static unsigned int arena_reserved_flags[NUM_ARENAS];
+static size_t arena_reserved_bytes[NUM_ARENAS];
+
+// Faults in `len` bytes at `addr` so first touches do not page fault
+static void prefault(uint8_t* addr, size_t len) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(addr, len, MADV_POPULATE_WRITE) == 0) return;
+#endif
+    // Fallback for older kernels: write to every page
+    for (size_t i = 0; i < len; i += PAGE_SIZE) {
+        ((volatile uint8_t*)addr)[i] = 0;
     }
 }
 
-void* my_malloc(size_t size) {
-    if (size == 0 || size > (2ULL * 1024 * 1024 * 1024)) return NULL;
+// Prefaults and/or locks the first `len` bytes of an arena's pool, skipping
+// what it already has
+static int reserve_arena(int arena, size_t len) {
+    len = (len + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    if (len == 0) return 0;
+    if (len <= arena_reserved_bytes[arena] &&
+        (reserve_flags & ~arena_reserved_flags[arena]) == 0) return 0;
 
-    // Handle small allocations with buddy allocator
-    if (size < SMALL_THRESHOLD) {
-        initialize_buddy();
-        return buddy_alloc(&global_buddy, global_buddy.min_block_size);
+    uint8_t* pool = arenas[arena].memory_pool;
+    if (reserve_flags & MALLOC_RESERVE_POPULATE) prefault(pool, len);
+    if ((reserve_flags & MALLOC_RESERVE_LOCK) && mlock(pool, len) != 0) {
+        // Keep what did succeed so a later call retries the lock only
+        arena_reserved_flags[arena] |= reserve_flags & ~MALLOC_RESERVE_LOCK;
+        return -1;
     }
-    
-    // Handle large allocations with mmap
+    arena_reserved_flags[arena] |= reserve_flags;
+    if (len > arena_reserved_bytes[arena]) arena_reserved_bytes[arena] = len;
+    return 0;
+}
+
+// Initialize an arena once
+static BuddyAllocator* initialize_arena(int arena) {
+    if (!arena_initialized[arena]) {
+        buddy_init(&arenas[arena]);
+        bitmap_init(&arena_colored[arena], arena_colored_bits[arena], ARENA_BLOCKS);
+        if (arena == ARENA_NO_DUMP || arena == ARENA_NO_DUMP + 1) {
+            madvise(arenas[arena].memory_pool, 1024 * 1024, MADV_DONTDUMP);
+        }
+        if (arena == ARENA_DEFAULT) malloc_small_base = (uintptr_t)arenas[arena].memory_pool;
+        arena_initialized[arena] = 1;
+    }
+    return &arenas[arena];
+}
+
+// Picks the arena for a small allocation from its hints
+static int select_arena(unsigned int flags, unsigned int group) {
+    // Placement first (no-dump, then locality group), then lifetime class
+    int lifetime = (flags & MALLOC_LONG_LIVED) ? 1 : 0;
+    if (flags & MALLOC_NO_DUMP) return ARENA_NO_DUMP + lifetime;
+    if (group != 0) return ARENA_GROUP + 2 * ((group - 1) % MALLOC_GROUP_ARENAS) + lifetime;
+    return ARENA_DEFAULT + lifetime;
+}
+
+// Moves a small object inside its block so that consecutive objects start
+// on different cache sets. Blocks are 1KB: they are already line aligned and
+// never share a line (pair) with another block.
+static void* color_block(int arena, uint8_t* block, size_t size, unsigned int flags) {
+    size_t step = (flags & MALLOC_THREAD_OWNED) ? CACHE_LINE_PAIR_SIZE : CACHE_LINE_SIZE;
+    size_t colors = (SMALL_THRESHOLD - size) / step + 1;
+    size_t color = arena_color[arena]++ % colors;
+    if (color != 0) {
+        bitmap_set(&arena_colored[arena], (block - arenas[arena].memory_pool) / arenas[arena].min_block_size);
+    }
+    return block + color * step;
+}
+
+// Decides whether this allocation goes to the guarded pool. A thread's
+// countdown starts at 0, so it first gets a random point of the sampling
+// period rather than sampling the thread's first allocation.
+static int guard_sample(void) {
+    if (guard_countdown == 0) {
+        uint64_t seed = (uintptr_t)&guard_countdown;
+        seed = (seed ^ (seed >> 17)) * 0x9E3779B97F4A7C15ULL;
+        guard_countdown = 1 + (unsigned int)(seed >> 32) % guard_sample_rate;
+    }
+    if (--guard_countdown != 0) return 0;
+    guard_countdown = guard_sample_rate;
+    return 1;
+}
+
+// Handle large allocations with mmap
+static void* large_alloc(size_t size, unsigned int flags) {
+    // Metadata header, padded to a cache line pair for thread-owned data
+    size_t header_size = (flags & MALLOC_THREAD_OWNED) ? CACHE_LINE_PAIR_SIZE : sizeof(size_t);
     // Calculate size including metadata header
-    size_t total_size = size + sizeof(size_t);
+    size_t total_size = size + header_size;
     // Round up to nearest page multiple
     size_t num_pages = (total_size + PAGE_SIZE - 1) / PAGE_SIZE;
     size_t alloc_size = num_pages * PAGE_SIZE;
     
-    // Allocate memory with mmap
+    // Allocate memory with mmap (anonymous mappings are already zeroed)
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (reserve_flags & MALLOC_RESERVE_POPULATE) map_flags |= MAP_POPULATE;
     void* base = mmap(NULL, alloc_size, PROT_READ | PROT_WRITE, 
-                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                     map_flags, -1, 0);
     if (base == MAP_FAILED) return NULL;
+    if (flags & MALLOC_NO_DUMP) madvise(base, alloc_size, MADV_DONTDUMP);
     
-    // Store allocation size in metadata header
-    *((size_t*)base) = alloc_size;
+    // Store allocation size in the last word of the metadata header
+    char* data = (char*)base + header_size;
+    *((size_t*)data - 1) = alloc_size;
     
     // Return pointer after metadata header
-    return (char*)base + sizeof(size_t);
+    return data;
+}
+
+void* my_malloc_hint(size_t size, unsigned int flags, unsigned int group) {
+    if (size == 0 || size > (2ULL * 1024 * 1024 * 1024)) return NULL;
+
+    // Send a sampled allocation to the guarded pool. Slots cannot honour
+    // placement hints (alignment, core-dump exclusion), so those are never sampled.
+    if (guard_sample_rate != 0 && size <= GUARD_SLOT_SIZE &&
+        !(flags & (MALLOC_COLORED | MALLOC_THREAD_OWNED | MALLOC_NO_DUMP)) && guard_sample()) {
+        void* ptr = guard_alloc(&guarded_pool, size);
+        if (ptr != NULL) {
+            if (flags & MALLOC_ZEROED) memset(ptr, 0, size);
+            return ptr;
+        }
+    }
+
+    // Handle small allocations with buddy allocator
+    if (size < SMALL_THRESHOLD) {
+        int arena = select_arena(flags, group);
+        BuddyAllocator* buddy = initialize_arena(arena);
+        void* ptr = buddy_alloc(buddy, buddy->min_block_size);
+        if (ptr != NULL && (flags & (MALLOC_COLORED | MALLOC_THREAD_OWNED))) {
+            ptr = color_block(arena, ptr, size, flags);
+        }
+        if (ptr != NULL && (flags & MALLOC_ZEROED)) memset(ptr, 0, size);
+        return ptr;
+    }
+
+    return large_alloc(size, flags);
+}
+
+void* my_malloc(size_t size) {
+    return my_malloc_hint(size, 0, 0);
+}
+
+int my_malloc_reserve(size_t bytes, unsigned int flags) {
+    reserve_flags |= flags;
+    if (bytes > reserve_bytes) reserve_bytes = bytes;
+
+    // `bytes` is a total: it fills the default arena first, then the
+    // long-lived one. Hint arenas are left to be created on first use.
+    size_t budget = reserve_bytes;
+    int result = 0;
+    for (int arena = ARENA_DEFAULT; arena <= ARENA_LONG_LIVED; arena++) {
+        size_t len = budget < 1024 * 1024 ? budget : 1024 * 1024;
+        initialize_arena(arena);
+        if (reserve_arena(arena, len) != 0) result = -1;
+        budget -= len;
+    }
+    return result;
+}
+
+// Reports faults in the guarded pool, then lets the access crash as usual
+static void guard_segv_handler(int sig, siginfo_t* info, void* context) {
+    if (guard_report(&guarded_pool, info->si_addr, STDERR_FILENO)) {
+        sigaction(SIGSEGV, &previous_segv, NULL);
+        return; // Re-executes the access under the previous handler
+    }
+
+    // Not ours: hand over to whatever was installed before
+    if (previous_segv.sa_flags & SA_SIGINFO) {
+        previous_segv.sa_sigaction(sig, info, context);
+    } else if (previous_segv.sa_handler != SIG_DFL && previous_segv.sa_handler != SIG_IGN) {
+        previous_segv.sa_handler(sig);
+    } else {
+        sigaction(SIGSEGV, &previous_segv, NULL);
+    }
+}
+
+void my_malloc_guard_enable(unsigned int sample_rate) {
+    if (sample_rate != 0 && guarded_pool.pool == NULL) {
+        guard_init(&guarded_pool);
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = guard_segv_handler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &previous_segv);
+    }
+    guard_sample_rate = sample_rate;
+    guard_countdown = sample_rate;
+}
+
+void my_malloc_thread_flush(void) {
+    while (malloc_tcache.count > 0) {
+        my_free(malloc_tcache.blocks[--malloc_tcache.count]);
+    }
+}
+
+static void tcache_destructor(void* value) {
+    (void)value;
+    my_malloc_thread_flush();
+}
+
+static void tcache_key_create(void) {
+    pthread_key_create(&tcache_key, tcache_destructor);
+}
+
+void my_malloc_thread_register(void) {
+    pthread_once(&tcache_key_once, tcache_key_create);
+    // Destructors only run for keys with a non-NULL value
+    pthread_setspecific(tcache_key, &malloc_tcache);
+    malloc_tcache.registered = 1;
+}
+
+// Warm up from the environment before main() runs
+__attribute__((constructor))
+static void reserve_from_env() {
+    const char* bytes = getenv("MY_MALLOC_RESERVE");
+    if (bytes == NULL) return;
+
+    unsigned int flags = 0;
+    const char* flag_list = getenv("MY_MALLOC_RESERVE_FLAGS");
+    // Comma-separated list of "populate" and "lock"
+    while (flag_list != NULL && *flag_list != '\0') {
+        size_t len = strcspn(flag_list, ",");
+        if (len == 8 && strncmp(flag_list, "populate", len) == 0) flags |= MALLOC_RESERVE_POPULATE;
+        if (len == 4 && strncmp(flag_list, "lock", len) == 0) flags |= MALLOC_RESERVE_LOCK;
+        flag_list += len;
+        if (*flag_list == ',') flag_list++;
+    }
+    my_malloc_reserve(strtoull(bytes, NULL, 0), flags);
+}
+
+// Enable sampled guard pages from the environment before main() runs
+__attribute__((constructor))
+static void guard_from_env() {
+    const char* rate = getenv("MY_MALLOC_GUARD_RATE");
+    if (rate != NULL) my_malloc_guard_enable(strtoul(rate, NULL, 0));
 }
 
 void my_free(void* ptr) {
     if (ptr == NULL) return;
     
-    uintptr_t buddy_start = (uintptr_t)global_buddy.memory_pool;
-    uintptr_t buddy_end = buddy_start + (1024 * 1024);
     uintptr_t current_ptr = (uintptr_t)ptr;
     
-    // Handle buddy allocations
-    if (current_ptr >= buddy_start && current_ptr < buddy_end) {
-        buddy_free(&global_buddy, ptr);
+    // Handle sampled allocations
+    if (guard_owns(&guarded_pool, ptr)) {
+        guard_free(&guarded_pool, ptr);
         return;
     }
     
+    // Handle buddy allocations
+    for (int i = 0; i < NUM_ARENAS; i++) {
+        if (!arena_initialized[i]) continue;
+        uintptr_t buddy_start = (uintptr_t)arenas[i].memory_pool;
+        uintptr_t buddy_end = buddy_start + (1024 * 1024);
+        if (current_ptr >= buddy_start && current_ptr < buddy_end) {
+            // Only colored objects start inside their block, a whole number
+            // of cache lines in: round those down and ignore other interior pointers
+            uint32_t block = (current_ptr - buddy_start) / arenas[i].min_block_size;
+            uintptr_t offset = current_ptr & (uintptr_t)(arenas[i].min_block_size - 1);
+            if (offset != 0 && (offset % CACHE_LINE_SIZE != 0 ||
+                                !bitmap_is_set(&arena_colored[i], block))) return;
+            bitmap_clear(&arena_colored[i], block);
+            buddy_free(&arenas[i], (void*)(current_ptr - offset));
+            return;
+        }
+    }
+    
     // Handle mmap allocations
-    // Retrieve metadata header
-    void* base = (void*)(current_ptr - sizeof(size_t));
-    size_t alloc_size = *((size_t*)base);
+    // Retrieve metadata header (the mapping starts at the header's page)
+    size_t alloc_size = *((size_t*)ptr - 1);
+    void* base = (void*)((current_ptr - sizeof(size_t)) & ~(uintptr_t)(PAGE_SIZE - 1));
     
     // Unmap memory
     munmap(base, alloc_size);
-}
\ No newline at end of file
+}
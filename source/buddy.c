@@ -1,10 +1,27 @@
+#define _GNU_SOURCE
 #include "buddy.h"
-#include "bitmap.h"
+#include "nodemap.h"
 
 #include <sys/mman.h>
+#include <sys/file.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// File-backed and shared heap layout: header page, node map page, then the 1MB pool
+#define BUDDY_FILE_MAGIC 0x5042554444594850ULL  // "PHYDDUBP"
+#define BUDDY_FILE_VERSION 1
+#define BUDDY_SHARED_MAGIC 0x5342554444594853ULL  // "SHYDDUBS"
+#define BUDDY_SHARED_VERSION 1
+#define BUDDY_REGION_PAGE 4096
+#define BUDDY_REGION_POOL_OFFSET (2 * BUDDY_REGION_PAGE)
+#define BUDDY_REGION_SIZE (BUDDY_REGION_POOL_OFFSET + 1048576)
 
 void buddy_init(BuddyAllocator* buddy) {
     // Allocate 1MB memory pool using mmap
@@ -14,33 +31,45 @@ void buddy_init(BuddyAllocator* buddy) {
         exit(EXIT_FAILURE);
     }
 
-    // Calculate the number of bits needed for split and allocation bitmaps
-    uint32_t split_bits_num = 1023;  // n - 1 = 1023
-    uint32_t alloc_bits_num = 2047;  // 2n - 1 = 2047
-
-    // Calculate buffer sizes for the bitmaps
-    uint32_t split_buffer_size = BitMap_getBytes(split_bits_num);
-    uint32_t alloc_buffer_size = BitMap_getBytes(alloc_bits_num);
-
-    // Allocate buffers for split and allocation bitmaps using mmap
-    uint8_t* split_buffer = mmap(NULL, split_buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (split_buffer == MAP_FAILED) {
-        perror("Failed to allocate split bitmap buffer");
+    // Allocate the node-state buffer using mmap (zeroed = every node free)
+    uint32_t nodes_buffer_size = NodeMap_getBytes(BUDDY_LEVELS);
+    uint8_t* nodes_buffer = mmap(NULL, nodes_buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (nodes_buffer == MAP_FAILED) {
+        perror("Failed to allocate node state buffer");
         exit(EXIT_FAILURE);
     }
 
-    uint8_t* alloc_buffer = mmap(NULL, alloc_buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (alloc_buffer == MAP_FAILED) {
-        perror("Failed to allocate allocation bitmap buffer");
-        exit(EXIT_FAILURE);
-    }
-
-    // Initialize the split and allocation bitmaps
-    bitmap_init(&buddy->split_bits, split_buffer, split_bits_num);
-    bitmap_init(&buddy->alloc_bits, alloc_buffer, alloc_bits_num);
+    // Initialize the node map
+    nodemap_init(&buddy->nodes, nodes_buffer, BUDDY_LEVELS);
 
     // Set the minimum block size to 1KB
     buddy->min_block_size = 1024;
+    buddy->policy = BUDDY_POLICY_SMALLEST;
+
+    // Start with empty quick lists
+    for (uint32_t l = 0; l < BUDDY_LEVELS; l++) buddy->quick_count[l] = 0;
+    buddy->file_header = NULL;
+    buddy->file_fd = -1;
+    buddy->shared_header = NULL;
+}
+
+static uint8_t recover_subtree(BuddyAllocator* buddy, uint32_t index, uint32_t level);
+
+// Takes the lock of a shared heap. A holder that died mid-update leaves
+// the node map inconsistent: repair it before going on.
+static int lock_shared(BuddyAllocator* buddy) {
+    if (buddy->shared_header == NULL) return 0;
+    int rc = pthread_mutex_lock(&buddy->shared_header->lock);
+    if (rc == EOWNERDEAD) {
+        recover_subtree(buddy, 0, 0);
+        pthread_mutex_consistent(&buddy->shared_header->lock);
+        rc = 0;
+    }
+    return rc == 0 ? 0 : -1;
+}
+
+static void unlock_shared(BuddyAllocator* buddy) {
+    if (buddy->shared_header != NULL) pthread_mutex_unlock(&buddy->shared_header->lock);
 }
 
 // Returns the level (0 = 1MB, 10 = 1KB) for a given block size
@@ -50,78 +79,212 @@ uint32_t get_level(uint32_t block_size) {
     return 20 - log2_block_size;  // 20 = log2(1MB)
 }
 
+// Recomputes the SPLIT/FULL state of every ancestor of `index`
+static void update_ancestors(BuddyAllocator* buddy, uint32_t index) {
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 2;
+        uint8_t left = nodemap_get(&buddy->nodes, 2 * parent + 1);
+        uint8_t right = nodemap_get(&buddy->nodes, 2 * parent + 2);
+        int full = (left == NODE_FULL || left == NODE_ALLOC) &&
+                   (right == NODE_FULL || right == NODE_ALLOC);
+        uint8_t state = full ? NODE_FULL : NODE_SPLIT;
+        if (nodemap_get(&buddy->nodes, parent) == state) break; // Rest is up to date
+        nodemap_set(&buddy->nodes, parent, state);
+        index = parent;
+    }
+}
+
 // Finds the first free block index at the specified level
 int32_t find_free_block(BuddyAllocator* buddy, uint32_t level) {
-    uint32_t start = (1 << level) - 1;
-    uint32_t end = (1 << (level + 1)) - 1;
-    for (uint32_t i = start; i < end; i++) {
-        // Skip allocated or split blocks
-        if (bitmap_is_set(&buddy->alloc_bits, i) || 
-            (level != 10 && bitmap_is_set(&buddy->split_bits, i))) {
+    uint32_t index = 0;
+    uint32_t l = 0;
+    while (1) {
+        uint8_t state = nodemap_get(&buddy->nodes, index);
+        if (l == level && state == NODE_FREE) return index;
+
+        // Descend only into split subtrees that still have free space
+        if (l < level && state == NODE_SPLIT) {
+            index = 2 * index + 1;
+            l++;
             continue;
         }
 
-        // Check if any ancestor is allocated (up to root)
-        int is_free = 1;
-        uint32_t current = i;
-        for (uint32_t l = level; l > 0; l--) {
-            uint32_t parent = (current - 1) / 2;
-            if (parent >= buddy->alloc_bits.num_bits || 
-                bitmap_is_set(&buddy->alloc_bits, parent)) {
-                is_free = 0;
-                break;
-            }
-            current = parent;
+        // Move to the next subtree: climb while on a right child
+        while (index > 0 && index % 2 == 0) {
+            index = (index - 1) / 2;
+            l--;
         }
-        if (is_free) return i;
+        if (index == 0) return -1;
+        index++;
     }
-    return -1;
 }
 
 // Splits a block recursively from `current_level` down to `target_level`
 void split_block(BuddyAllocator* buddy, uint32_t index, 
                   uint32_t current_level, uint32_t target_level) {
     for (uint32_t l = current_level; l < target_level; l++) {
-        if (index >= buddy->split_bits.num_bits) break; // Guard split bitmap
-        bitmap_set(&buddy->split_bits, index);
+        nodemap_set(&buddy->nodes, index, NODE_SPLIT);
         index = 2 * index + 1; // Move to left child
     }
 }
 
 // Finds the block index and level for a given memory offset
 int32_t find_block_index(BuddyAllocator* buddy, uint32_t offset, uint32_t* out_level) {
-    for (int32_t l = 10; l >= 0; l--) {
-        uint32_t block_size = 1048576 >> l;
-        if (block_size < 1024) continue;
-        if (offset % block_size != 0) continue;
-
-        uint32_t start = (1 << l) - 1;
-        uint32_t index = start + (offset / block_size);
-        if (index < (uint32_t)((1 << (l + 1)) - 1) && 
-            bitmap_is_set(&buddy->alloc_bits, index)) {
-            *out_level = l;
-            return index;
-        }
+    uint32_t index = 0;
+    uint32_t level = 0;
+    uint32_t block_size = 1048576;
+
+    // Follow split nodes down to the block containing `offset`
+    uint8_t state = nodemap_get(&buddy->nodes, index);
+    while ((state == NODE_SPLIT || state == NODE_FULL) && level < 10) {
+        block_size >>= 1;
+        index = 2 * index + 1 + ((offset & block_size) ? 1 : 0);
+        level++;
+        state = nodemap_get(&buddy->nodes, index);
     }
-    return -1;
+
+    if (state != NODE_ALLOC || offset % block_size != 0) return -1;
+    *out_level = level;
+    return index;
 }
 
 // Merges free buddies upwards recursively
 void merge_buddies(BuddyAllocator* buddy, uint32_t index, uint32_t level) {
-    while (level < 10) {
-        uint32_t parent_index = (index - 1) / 2;
-        if (parent_index >= buddy->split_bits.num_bits) break; // Guard
-
-        uint32_t buddy_index = index ^ 1;
-        if (bitmap_is_set(&buddy->alloc_bits, buddy_index) || 
-            bitmap_is_set(&buddy->split_bits, parent_index)) {
-            break; // Buddy is allocated or parent is split
+    while (level > 0) {
+        uint32_t buddy_index = ((index - 1) ^ 1) + 1;
+        if (nodemap_get(&buddy->nodes, buddy_index) != NODE_FREE) {
+            break; // Buddy is allocated or split
         }
 
-        bitmap_clear(&buddy->split_bits, parent_index);
+        uint32_t parent_index = (index - 1) / 2;
+        nodemap_set(&buddy->nodes, parent_index, NODE_FREE);
         index = parent_index;
         level--;
     }
+    update_ancestors(buddy, index);
+}
+
+// Marks a block free in the tree and coalesces it with its buddies
+static void release_block(BuddyAllocator* buddy, uint32_t index, uint32_t level) {
+    nodemap_set(&buddy->nodes, index, NODE_FREE);
+    merge_buddies(buddy, index, level);
+}
+
+// Returns every block cached at `level` to the tree
+static void flush_level(BuddyAllocator* buddy, uint32_t level) {
+    while (buddy->quick_count[level] > 0) {
+        uint32_t index = buddy->quick_list[level][--buddy->quick_count[level]];
+        release_block(buddy, index, level);
+    }
+}
+
+// Returns the oldest half of the blocks cached at `level` to the tree,
+// keeping the most recently freed (hot) ones cached
+static void trim_level(BuddyAllocator* buddy, uint32_t level) {
+    uint32_t count = buddy->quick_count[level];
+    uint32_t released = count / 2;
+    for (uint32_t i = 0; i < released; i++) {
+        release_block(buddy, buddy->quick_list[level][i], level);
+    }
+    for (uint32_t i = released; i < count; i++) {
+        buddy->quick_list[level][i - released] = buddy->quick_list[level][i];
+    }
+    buddy->quick_count[level] = count - released;
+}
+
+void buddy_flush(BuddyAllocator* buddy) {
+    for (uint32_t l = 0; l < BUDDY_LEVELS; l++) flush_level(buddy, l);
+}
+
+// Finds a free block at `level`, preferring one whose buddy is allocated or
+// full: the partly used neighbourhoods are left to coalesce
+static int32_t find_best_block(BuddyAllocator* buddy, uint32_t level) {
+    int32_t candidate = -1;
+    uint32_t index = 0;
+    uint32_t l = 0;
+    while (1) {
+        uint8_t state = nodemap_get(&buddy->nodes, index);
+        if (l == level && state == NODE_FREE) {
+            if (index == 0) return 0;
+            uint8_t buddy_state = nodemap_get(&buddy->nodes, ((index - 1) ^ 1) + 1);
+            if (buddy_state == NODE_ALLOC || buddy_state == NODE_FULL) return index;
+            if (candidate == -1) candidate = index;
+        }
+
+        // Descend only into split subtrees that still have free space
+        if (l < level && state == NODE_SPLIT) {
+            index = 2 * index + 1;
+            l++;
+            continue;
+        }
+
+        // Move to the next subtree: climb while on a right child
+        while (index > 0 && index % 2 == 0) {
+            index = (index - 1) / 2;
+            l--;
+        }
+        if (index == 0) return candidate;
+        index++;
+    }
+}
+
+// Finds the lowest-address free block at `max_level` or above
+static int32_t find_first_fit(BuddyAllocator* buddy, uint32_t max_level, uint32_t* out_level) {
+    uint32_t index = 0;
+    uint32_t l = 0;
+    while (1) {
+        uint8_t state = nodemap_get(&buddy->nodes, index);
+        if (state == NODE_FREE) {
+            *out_level = l;
+            return index;
+        }
+
+        // Descend only into split subtrees that still have free space
+        if (l < max_level && state == NODE_SPLIT) {
+            index = 2 * index + 1;
+            l++;
+            continue;
+        }
+
+        // Move to the next subtree: climb while on a right child
+        while (index > 0 && index % 2 == 0) {
+            index = (index - 1) / 2;
+            l--;
+        }
+        if (index == 0) return -1;
+        index++;
+    }
+}
+
+void buddy_set_policy(BuddyAllocator* buddy, uint32_t policy) {
+    if (policy <= BUDDY_POLICY_ADDRESS) buddy->policy = policy;
+}
+
+// Allocates a block at `target_level` from the tree, splitting if needed
+static int32_t tree_alloc(BuddyAllocator* buddy, uint32_t target_level) {
+    int32_t index = -1;
+    uint32_t level = target_level;
+
+    if (buddy->policy == BUDDY_POLICY_ADDRESS) {
+        index = find_first_fit(buddy, target_level, &level);
+    } else {
+        // Try the target level first, then split the smallest larger block
+        for (int32_t l = target_level; l >= 0 && index == -1; l--) {
+            level = l;
+            index = buddy->policy == BUDDY_POLICY_BEST_FIT ? find_best_block(buddy, l)
+                                                           : find_free_block(buddy, l);
+        }
+    }
+    if (index == -1) return -1; // Out of memory
+
+    if (level < target_level) {
+        split_block(buddy, index, level, target_level);
+        uint32_t splits = target_level - level;
+        index = (index << splits) | ((1 << splits) - 1);
+    }
+    nodemap_set(&buddy->nodes, index, NODE_ALLOC);
+    update_ancestors(buddy, index);
+    return index;
 }
 
 void* buddy_alloc(BuddyAllocator* buddy, uint32_t size) {
@@ -135,30 +298,25 @@ void* buddy_alloc(BuddyAllocator* buddy, uint32_t size) {
         if (block_size > 1048576) return NULL;
     }
     uint32_t target_level = get_level(block_size);
+    if (lock_shared(buddy) != 0) return NULL;
 
-    // Try to allocate directly at target level
-    int32_t index = find_free_block(buddy, target_level);
-    if (index != -1) {
-        bitmap_set(&buddy->alloc_bits, index);
-        uint32_t offset = (index - ((1 << target_level) - 1)) * block_size;
-        return buddy->memory_pool + offset;
-    }
-
-    // Search higher levels and split
-    for (int32_t current_level = target_level - 1; current_level >= 0; current_level--) {
-        index = find_free_block(buddy, current_level);
-        if (index != -1) {
-            split_block(buddy, index, current_level, target_level);
-            uint32_t splits = target_level - current_level;
-            uint32_t final_index = (index << splits) | ((1 << splits) - 1);
-            if (final_index >= buddy->alloc_bits.num_bits) return NULL; // Guard
-            bitmap_set(&buddy->alloc_bits, final_index);
-            uint32_t offset = (final_index - ((1 << target_level) - 1)) * block_size;
-            return buddy->memory_pool + offset;
+    // Reuse a recently freed block of the same size
+    int32_t index;
+    if (buddy->quick_count[target_level] > 0) {
+        index = buddy->quick_list[target_level][--buddy->quick_count[target_level]];
+    } else {
+        index = tree_alloc(buddy, target_level);
+        if (index == -1) {
+            // Coalesce the cached blocks and retry once
+            buddy_flush(buddy);
+            index = tree_alloc(buddy, target_level);
         }
     }
+    unlock_shared(buddy);
+    if (index == -1) return NULL; // Out of memory
 
-    return NULL; // Out of memory
+    uint32_t offset = (index - ((1 << target_level) - 1)) * block_size;
+    return buddy->memory_pool + offset;
 }
 
 void buddy_free(BuddyAllocator* buddy, void* ptr) {
@@ -170,14 +328,278 @@ void buddy_free(BuddyAllocator* buddy, void* ptr) {
 
     uint32_t offset = (uint8_t*)ptr - buddy->memory_pool;
     uint32_t level;
+
+    // Shared heaps release at once under the lock: other processes cannot see
+    // this process's quick lists
+    if (buddy->shared_header != NULL) {
+        if (lock_shared(buddy) != 0) return;
+        int32_t index = find_block_index(buddy, offset, &level);
+        if (index != -1) release_block(buddy, index, level);
+        unlock_shared(buddy);
+        return;
+    }
+
     int32_t index = find_block_index(buddy, offset, &level);
-    if (index == -1) return;
+    if (index == -1) return; // Not allocated
 
-    // Check double free
-    if (!bitmap_is_set(&buddy->alloc_bits, index)) {
+    // Blocks in a quick list are still marked allocated: check double free
+    for (uint32_t i = 0; i < buddy->quick_count[level]; i++) {
+        if (buddy->quick_list[level][i] == (uint32_t)index) return;
+    }
+
+    // A file-backed heap releases at once so a crash cannot leak cached blocks
+    if (buddy->file_header != NULL) {
+        release_block(buddy, index, level);
         return;
     }
 
-    bitmap_clear(&buddy->alloc_bits, index);
-    merge_buddies(buddy, index, level);
-}
\ No newline at end of file
+    // Defer coalescing until the quick list overflows
+    if (buddy->quick_count[level] == BUDDY_QUICK_LIST_SIZE) {
+        trim_level(buddy, level);
+    }
+    buddy->quick_list[level][buddy->quick_count[level]++] = index;
+}
+
+// Marks every descendant of `index` free
+static void clear_subtree(BuddyAllocator* buddy, uint32_t index, uint32_t level) {
+    if (level >= 10) return;
+    for (uint32_t child = 2 * index + 1; child <= 2 * index + 2; child++) {
+        nodemap_set(&buddy->nodes, child, NODE_FREE);
+        clear_subtree(buddy, child, level + 1);
+    }
+}
+
+// Rebuilds a consistent subtree after a crash and returns its root state.
+// Allocations are kept; stale split/full marks are recomputed and nodes
+// below a free or allocated block are cleared.
+static uint8_t recover_subtree(BuddyAllocator* buddy, uint32_t index, uint32_t level) {
+    uint8_t state = nodemap_get(&buddy->nodes, index);
+    if (state == NODE_FREE || state == NODE_ALLOC || level == 10) {
+        if (level == 10 && state != NODE_ALLOC) state = NODE_FREE;
+        nodemap_set(&buddy->nodes, index, state);
+        clear_subtree(buddy, index, level);
+        return state;
+    }
+
+    uint8_t left = recover_subtree(buddy, 2 * index + 1, level + 1);
+    uint8_t right = recover_subtree(buddy, 2 * index + 2, level + 1);
+    if (left == NODE_FREE && right == NODE_FREE) {
+        state = NODE_FREE;
+    } else if ((left == NODE_FULL || left == NODE_ALLOC) &&
+               (right == NODE_FULL || right == NODE_ALLOC)) {
+        state = NODE_FULL;
+    } else {
+        state = NODE_SPLIT;
+    }
+    nodemap_set(&buddy->nodes, index, state);
+    return state;
+}
+
+int buddy_init_file(BuddyAllocator* buddy, const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        perror("Failed to open heap file");
+        return -1;
+    }
+
+    // One allocator per file: two would hand out the same blocks
+    if (flock(fd, LOCK_EX | LOCK_NB) == -1) {
+        if (errno == EWOULDBLOCK) fprintf(stderr, "Heap file %s is in use\n", path);
+        else perror("Failed to lock heap file");
+        close(fd);
+        return -1;
+    }
+
+    // A new file is sized here; an existing one must match the layout
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror("Failed to stat heap file");
+        close(fd);
+        return -1;
+    }
+    int created = st.st_size == 0;
+    if (created && ftruncate(fd, BUDDY_REGION_SIZE) == -1) {
+        perror("Failed to size heap file");
+        close(fd);
+        return -1;
+    }
+    if (!created && st.st_size != BUDDY_REGION_SIZE) {
+        fprintf(stderr, "Heap file %s has an unexpected size\n", path);
+        close(fd);
+        return -1;
+    }
+
+    // Map header, node map and pool at any base: everything is offset-based
+    uint8_t* base = mmap(NULL, BUDDY_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("Failed to map heap file");
+        close(fd);
+        return -1;
+    }
+
+    // A crash between sizing the file and writing its header leaves zeros
+    BuddyFileHeader* header = (BuddyFileHeader*)base;
+    if (!created) {
+        created = 1;
+        for (size_t i = 0; i < sizeof(*header); i++) {
+            if (((uint8_t*)header)[i] != 0) created = 0;
+        }
+    }
+    if (created) {
+        memset(header, 0, sizeof(*header));
+        header->magic = BUDDY_FILE_MAGIC;
+        header->version = BUDDY_FILE_VERSION;
+        header->pool_size = 1048576;
+        header->nodes_size = NodeMap_getBytes(BUDDY_LEVELS);
+        header->clean = 1;
+    } else if (header->magic != BUDDY_FILE_MAGIC || header->version != BUDDY_FILE_VERSION ||
+               header->pool_size != 1048576 || header->nodes_size != NodeMap_getBytes(BUDDY_LEVELS)) {
+        fprintf(stderr, "Heap file %s has an unknown layout\n", path);
+        munmap(base, BUDDY_REGION_SIZE);
+        close(fd);
+        return -1;
+    }
+
+    buddy->memory_pool = base + BUDDY_REGION_POOL_OFFSET;
+    nodemap_init(&buddy->nodes, base + BUDDY_REGION_PAGE, BUDDY_LEVELS);
+    buddy->min_block_size = 1024;
+    buddy->policy = BUDDY_POLICY_SMALLEST;
+    for (uint32_t l = 0; l < BUDDY_LEVELS; l++) buddy->quick_count[l] = 0;
+    buddy->file_header = header;
+    buddy->file_fd = fd;
+    buddy->shared_header = NULL;
+
+    // Not detached cleanly: repair the node map before use
+    if (!header->clean) recover_subtree(buddy, 0, 0);
+
+    // Mark the heap in use until buddy_close
+    header->clean = 0;
+    msync(header, BUDDY_REGION_PAGE, MS_SYNC);
+    return 0;
+}
+
+int buddy_sync(BuddyAllocator* buddy) {
+    if (buddy->file_header == NULL) return -1;
+
+    // Pool data first, then the metadata that refers to it
+    if (msync(buddy->memory_pool, 1048576, MS_SYNC) == -1) return -1;
+    if (msync(buddy->nodes.buffer, BUDDY_REGION_PAGE, MS_SYNC) == -1) return -1;
+    return msync(buddy->file_header, BUDDY_REGION_PAGE, MS_SYNC);
+}
+
+void buddy_close(BuddyAllocator* buddy) {
+    if (buddy->file_header == NULL) return;
+
+    buddy_flush(buddy);
+    buddy_sync(buddy);
+    buddy->file_header->clean = 1;
+    msync(buddy->file_header, BUDDY_REGION_PAGE, MS_SYNC);
+
+    munmap(buddy->file_header, BUDDY_REGION_SIZE);
+    close(buddy->file_fd); // Releases the lock
+    buddy->file_header = NULL;
+    buddy->file_fd = -1;
+    buddy->memory_pool = NULL;
+}
+
+void buddy_set_root(BuddyAllocator* buddy, uint32_t slot, void* ptr) {
+    if (buddy->file_header == NULL || slot >= BUDDY_FILE_ROOTS) return;
+    buddy->file_header->roots[slot] = ptr == NULL ? 0 : (uint64_t)((uint8_t*)ptr - buddy->memory_pool) + 1;
+}
+
+void* buddy_get_root(const BuddyAllocator* buddy, uint32_t slot) {
+    if (buddy->file_header == NULL || slot >= BUDDY_FILE_ROOTS) return NULL;
+    uint64_t root = buddy->file_header->roots[slot];
+    // A corrupted file must not yield a pointer outside the pool
+    if (root == 0 || root - 1 >= 1048576) return NULL;
+    return buddy->memory_pool + (root - 1);
+}
+
+// Points `buddy` at a mapped shared region
+static void map_shared(BuddyAllocator* buddy, uint8_t* base) {
+    buddy->memory_pool = base + BUDDY_REGION_POOL_OFFSET;
+    nodemap_init(&buddy->nodes, base + BUDDY_REGION_PAGE, BUDDY_LEVELS);
+    buddy->min_block_size = 1024;
+    buddy->policy = BUDDY_POLICY_SMALLEST;
+    for (uint32_t l = 0; l < BUDDY_LEVELS; l++) buddy->quick_count[l] = 0;
+    buddy->file_header = NULL;
+    buddy->file_fd = -1;
+    buddy->shared_header = (BuddySharedHeader*)base;
+}
+
+int buddy_create_shared(BuddyAllocator* buddy) {
+    int fd = memfd_create("buddy_shared", MFD_CLOEXEC);
+    if (fd == -1) {
+        perror("Failed to create shared heap");
+        return -1;
+    }
+    if (ftruncate(fd, BUDDY_REGION_SIZE) == -1) {
+        perror("Failed to size shared heap");
+        close(fd);
+        return -1;
+    }
+
+    uint8_t* base = mmap(NULL, BUDDY_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("Failed to map shared heap");
+        close(fd);
+        return -1;
+    }
+
+    // Initialize the header before anyone else can attach (the region is zeroed)
+    BuddySharedHeader* header = (BuddySharedHeader*)base;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    header->magic = BUDDY_SHARED_MAGIC;
+    header->version = BUDDY_SHARED_VERSION;
+    header->pool_size = 1048576;
+
+    map_shared(buddy, base);
+    return fd;
+}
+
+int buddy_attach_shared(BuddyAllocator* buddy, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size != BUDDY_REGION_SIZE) {
+        fprintf(stderr, "Not a shared buddy heap\n");
+        return -1;
+    }
+
+    uint8_t* base = mmap(NULL, BUDDY_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("Failed to map shared heap");
+        return -1;
+    }
+
+    BuddySharedHeader* header = (BuddySharedHeader*)base;
+    if (header->magic != BUDDY_SHARED_MAGIC || header->version != BUDDY_SHARED_VERSION ||
+        header->pool_size != 1048576) {
+        fprintf(stderr, "Not a shared buddy heap\n");
+        munmap(base, BUDDY_REGION_SIZE);
+        return -1;
+    }
+
+    map_shared(buddy, base);
+    return 0;
+}
+
+void buddy_detach_shared(BuddyAllocator* buddy) {
+    if (buddy->shared_header == NULL) return;
+
+    munmap(buddy->shared_header, BUDDY_REGION_SIZE);
+    buddy->shared_header = NULL;
+    buddy->memory_pool = NULL;
+}
+
+uint32_t buddy_to_offset(const BuddyAllocator* buddy, void* ptr) {
+    return (uint8_t*)ptr - buddy->memory_pool;
+}
+
+void* buddy_from_offset(const BuddyAllocator* buddy, uint32_t offset) {
+    if (offset >= 1048576) return NULL;
+    return buddy->memory_pool + offset;
+}
@@ -0,0 +1,118 @@
+#include "guard.h"
+
+#include <sys/mman.h>
+#include <execinfo.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Objects are right-aligned to this boundary inside their slot
+#define GUARD_ALIGNMENT 16
+
+// Returns the first byte of slot `i`
+static uint8_t* slot_page(const GuardedPool* guard, uint32_t i) {
+    return guard->pool + (2 * i + 1) * GUARD_SLOT_SIZE;
+}
+
+void guard_init(GuardedPool* guard) {
+    // Slots and guard pages alternate, with a guard page at both ends
+    guard->pool_size = (2 * GUARD_SLOTS + 1) * GUARD_SLOT_SIZE;
+    guard->pool = mmap(NULL, guard->pool_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (guard->pool == MAP_FAILED) {
+        perror("Failed to allocate guarded pool");
+        exit(EXIT_FAILURE);
+    }
+    guard->next_slot = 0;
+    memset(guard->slots, 0, sizeof(guard->slots));
+}
+
+void* guard_alloc(GuardedPool* guard, size_t size) {
+    if (size == 0 || size > GUARD_SLOT_SIZE) return NULL;
+
+    // Take the next slot not in use, starting after the last one handed out
+    for (uint32_t n = 0; n < GUARD_SLOTS; n++) {
+        uint32_t i = (guard->next_slot + n) % GUARD_SLOTS;
+        GuardSlot* slot = &guard->slots[i];
+        if (slot->state == GUARD_SLOT_LIVE) continue;
+
+        uint8_t* page = slot_page(guard, i);
+        if (mprotect(page, GUARD_SLOT_SIZE, PROT_READ | PROT_WRITE) != 0) return NULL;
+
+        // Right-align so overflows run into the next guard page
+        size_t padded = (size + GUARD_ALIGNMENT - 1) & ~(size_t)(GUARD_ALIGNMENT - 1);
+        slot->ptr = page + GUARD_SLOT_SIZE - padded;
+        slot->size = size;
+        slot->state = GUARD_SLOT_LIVE;
+        slot->alloc_depth = backtrace(slot->alloc_stack, GUARD_STACK_DEPTH);
+        slot->free_depth = 0;
+        guard->next_slot = (i + 1) % GUARD_SLOTS;
+        return slot->ptr;
+    }
+    return NULL; // Every slot is live
+}
+
+int guard_owns(const GuardedPool* guard, const void* ptr) {
+    return guard->pool != NULL &&
+           (uintptr_t)ptr >= (uintptr_t)guard->pool &&
+           (uintptr_t)ptr < (uintptr_t)guard->pool + guard->pool_size;
+}
+
+// Returns the slot nearest to `addr` (a guard page is reported against its left slot,
+// or the right one for the leading guard page)
+static uint32_t nearest_slot(const GuardedPool* guard, const void* addr) {
+    size_t page = ((uintptr_t)addr - (uintptr_t)guard->pool) / GUARD_SLOT_SIZE;
+    if (page == 0) return 0;
+    uint32_t i = (page - 1) / 2;
+    return i < GUARD_SLOTS ? i : GUARD_SLOTS - 1;
+}
+
+void guard_free(GuardedPool* guard, void* ptr) {
+    uint32_t i = nearest_slot(guard, ptr);
+    GuardSlot* slot = &guard->slots[i];
+    if (slot->state != GUARD_SLOT_LIVE || slot->ptr != ptr) {
+        // Double or invalid free: report it and leave the slot alone
+        dprintf(STDERR_FILENO, "guard: %s of %p\n",
+                slot->state == GUARD_SLOT_FREED ? "double free" : "invalid free", ptr);
+        guard_report(guard, ptr, STDERR_FILENO);
+        return;
+    }
+
+    // Keep the free stack and make any later access fault
+    slot->state = GUARD_SLOT_FREED;
+    slot->free_depth = backtrace(slot->free_stack, GUARD_STACK_DEPTH);
+    mprotect(slot_page(guard, i), GUARD_SLOT_SIZE, PROT_NONE);
+}
+
+int guard_report(const GuardedPool* guard, const void* addr, int fd) {
+    if (!guard_owns(guard, addr)) return 0;
+
+    uint32_t i = nearest_slot(guard, addr);
+    const GuardSlot* slot = &guard->slots[i];
+    const char* kind;
+    if (slot->state == GUARD_SLOT_FREED) {
+        kind = "use-after-free";
+    } else if (slot->state == GUARD_SLOT_EMPTY) {
+        kind = "wild access";
+    } else if ((const uint8_t*)addr >= slot->ptr + slot->size) {
+        kind = "buffer overflow";
+    } else if ((const uint8_t*)addr < slot->ptr) {
+        kind = "buffer underflow";
+    } else {
+        kind = "invalid free";
+    }
+
+    // dprintf/backtrace_symbols_fd do not use the heap
+    dprintf(fd, "guard: %s at %p, %zu-byte object at %p (slot %u)\n",
+            kind, addr, slot->size, (void*)slot->ptr, i);
+    if (slot->alloc_depth > 0) {
+        dprintf(fd, "guard: allocated at:\n");
+        backtrace_symbols_fd(slot->alloc_stack, slot->alloc_depth, fd);
+    }
+    if (slot->free_depth > 0) {
+        dprintf(fd, "guard: freed at:\n");
+        backtrace_symbols_fd(slot->free_stack, slot->free_depth, fd);
+    }
+    return 1;
+}
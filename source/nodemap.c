@@ -0,0 +1,69 @@
+#include "nodemap.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+// Returns the number of levels stored in the top block and below it.
+static void nodemap_bands(uint32_t num_levels, uint32_t* top, uint32_t* bottom) {
+    *top = num_levels < NODEMAP_TOP_LEVELS ? num_levels : NODEMAP_TOP_LEVELS;
+    *bottom = num_levels - *top;
+}
+
+// Maps a heap-ordered node index to its slot in the blocked layout.
+static uint32_t nodemap_slot(const NodeMap* nm, uint32_t index) {
+    uint32_t top, bottom;
+    nodemap_bands(nm->num_levels, &top, &bottom);
+
+    uint32_t pos = index + 1;                    // 1-based heap position
+    uint32_t level = 31 - __builtin_clz(pos);
+    if (level < top) return index;
+
+    // Locate the subtree rooted at level `top` and the node inside it
+    uint32_t depth = level - top;
+    uint32_t subtree = (pos >> depth) - (1u << top);
+    uint32_t local = (1u << depth) - 1 + (pos & ((1u << depth) - 1));
+    return (1u << top) + subtree * (1u << bottom) + local;
+}
+
+// Calculates the number of bytes required to store a tree with `num_levels` levels.
+uint32_t NodeMap_getBytes(uint32_t num_levels) {
+    if (num_levels == 0) return 0;
+    uint32_t top, bottom;
+    nodemap_bands(num_levels, &top, &bottom);
+    uint32_t slots = 1u << top;
+    if (bottom > 0) slots += (1u << top) * (1u << bottom);
+    return (slots * 2 + 7) / 8;
+}
+
+// Initializes a NodeMap structure with the given buffer and number of levels.
+void nodemap_init(NodeMap* nm, uint8_t* buffer, uint32_t num_levels) {
+    assert(num_levels <= 16);
+    nm->buffer = buffer;
+    nm->buffer_size = NodeMap_getBytes(num_levels);
+    nm->num_levels = num_levels;
+    nm->num_nodes = (1u << num_levels) - 1;
+}
+
+// Returns the 2-bit state of the node at the specified index.
+uint8_t nodemap_get(const NodeMap* nm, uint32_t index) {
+    assert(index < nm->num_nodes);
+    uint32_t slot = nodemap_slot(nm, index);
+    uint8_t shift = (slot % 4) * 2;
+    return (nm->buffer[slot / 4] >> shift) & 0x3;
+}
+
+// Stores the 2-bit state of the node at the specified index.
+void nodemap_set(NodeMap* nm, uint32_t index, uint8_t state) {
+    assert(index < nm->num_nodes);
+    assert(state <= NODE_ALLOC);
+    uint32_t slot = nodemap_slot(nm, index);
+    uint8_t shift = (slot % 4) * 2;
+    uint8_t mask = 0x3 << shift;
+    nm->buffer[slot / 4] = (nm->buffer[slot / 4] & ~mask) | (state << shift);
+}
+
+// Returns the byte of the buffer that holds the state of the node at the specified index.
+uint32_t nodemap_byte(const NodeMap* nm, uint32_t index) {
+    assert(index < nm->num_nodes);
+    return nodemap_slot(nm, index) / 4;
+}
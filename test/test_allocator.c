@@ -1,8 +1,14 @@
 #include "allocator.h"
+#include "allocator_inline.h"
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #define PAGE_SIZE 4096
 #define SMALL_THRESHOLD (PAGE_SIZE / 4)  // 1024 bytes
@@ -154,6 +160,314 @@ void test_edge_cases() {
     printf("Passed\n");
 }
 
+// Test 7: Allocation hints
+void test_allocation_hints() {
+    printf("Test 7: Allocation hints... ");
+    // Short- and long-lived blocks come from different arenas
+    void* short_ptr = my_malloc_hint(128, MALLOC_SHORT_LIVED, 0);
+    void* long_ptr = my_malloc_hint(128, MALLOC_LONG_LIVED, 0);
+    assert(short_ptr != NULL && long_ptr != NULL);
+    intptr_t distance = (intptr_t)long_ptr - (intptr_t)short_ptr;
+    assert((distance >= BUDDY_POOL_SIZE || distance <= -BUDDY_POOL_SIZE) && "Lifetime classes share an arena");
+    
+    // Same locality group shares an arena, different groups do not
+    void* group1a = my_malloc_hint(64, 0, 1);
+    void* group1b = my_malloc_hint(64, 0, 1);
+    void* group2 = my_malloc_hint(64, 0, 2);
+    assert(group1a != NULL && group1b != NULL && group2 != NULL);
+    distance = (intptr_t)group1b - (intptr_t)group1a;
+    assert(distance < BUDDY_POOL_SIZE && distance > -BUDDY_POOL_SIZE);
+    distance = (intptr_t)group2 - (intptr_t)group1a;
+    assert(distance >= BUDDY_POOL_SIZE || distance <= -BUDDY_POOL_SIZE);
+    
+    // Lifetime classes stay apart inside a group and in the no-dump arena
+    void* group1_long = my_malloc_hint(64, MALLOC_LONG_LIVED, 1);
+    void* no_dump_short = my_malloc_hint(64, MALLOC_NO_DUMP, 1);
+    void* no_dump_long = my_malloc_hint(64, MALLOC_NO_DUMP | MALLOC_LONG_LIVED, 1);
+    assert(group1_long != NULL && no_dump_short != NULL && no_dump_long != NULL);
+    distance = (intptr_t)group1_long - (intptr_t)group1a;
+    assert(distance >= BUDDY_POOL_SIZE || distance <= -BUDDY_POOL_SIZE);
+    distance = (intptr_t)group1_long - (intptr_t)long_ptr;
+    assert(distance >= BUDDY_POOL_SIZE || distance <= -BUDDY_POOL_SIZE);
+    distance = (intptr_t)no_dump_long - (intptr_t)no_dump_short;
+    assert(distance >= BUDDY_POOL_SIZE || distance <= -BUDDY_POOL_SIZE);
+    my_free(group1_long);
+    my_free(no_dump_short);
+    my_free(no_dump_long);
+    
+    // Zeroed memory even when the block is reused
+    memset(short_ptr, 0xEE, 128);
+    my_free(short_ptr);
+    char* zeroed = my_malloc_hint(128, MALLOC_ZEROED, 0);
+    assert(zeroed != NULL);
+    for (int i = 0; i < 128; i++) {
+        assert(zeroed[i] == 0 && "Memory not zeroed");
+    }
+    
+    // No-dump allocations, small and large
+    void* no_dump_small = my_malloc_hint(256, MALLOC_NO_DUMP, 0);
+    void* no_dump_large = my_malloc_hint(2 * PAGE_SIZE, MALLOC_NO_DUMP | MALLOC_ZEROED, 0);
+    assert(no_dump_small != NULL && no_dump_large != NULL);
+    memset(no_dump_small, 0x55, 256);
+    memset(no_dump_large, 0x66, 2 * PAGE_SIZE);
+    
+    my_free(long_ptr);
+    my_free(group1a);
+    my_free(group1b);
+    my_free(group2);
+    my_free(zeroed);
+    my_free(no_dump_small);
+    my_free(no_dump_large);
+    printf("Passed\n");
+}
+
+// Locked memory of this process (VmLck), in kB
+static long locked_kb() {
+    FILE* status = fopen("/proc/self/status", "r");
+    assert(status != NULL);
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (sscanf(line, "VmLck: %ld kB", &kb) == 1) break;
+    }
+    fclose(status);
+    return kb;
+}
+
+// Test 8: Eager reservation and prefaulting
+void test_reserve() {
+    printf("Test 8: Reserve and prefault... ");
+    assert(my_malloc_reserve(64 * 1024, MALLOC_RESERVE_POPULATE | MALLOC_RESERVE_LOCK) == 0);
+    assert(locked_kb() == 64 && "Reservation is a total, not per arena");
+    assert(my_malloc_reserve(64 * 1024, MALLOC_RESERVE_LOCK) == 0);
+    assert(locked_kb() == 64);
+    
+    // Small allocations keep working out of the reserved arena
+    void* small = my_malloc(100);
+    assert(small != NULL);
+    memset(small, 0x77, 100);
+    
+    // Large mappings are now populated before the first touch
+    size_t large_size = 4 * PAGE_SIZE;
+    void* large = my_malloc(large_size);
+    assert(large != NULL);
+    void* page = (void*)((uintptr_t)large & ~(uintptr_t)(PAGE_SIZE - 1));
+    unsigned char resident[5];
+    assert(mincore(page, 5 * PAGE_SIZE, resident) == 0);
+    for (int i = 0; i < 5; i++) {
+        assert((resident[i] & 1) && "Page not prefaulted");
+    }
+    
+    my_free(small);
+    my_free(large);
+    printf("Passed\n");
+}
+
+// Caches one freed block in a new thread and exits without flushing
+static void* cache_and_exit(void* arg) {
+    void* ptr = my_malloc_inline(64);
+    assert(ptr != NULL);
+    my_free_inline(ptr);
+    assert(malloc_tcache.count == 1);
+    *(void**)arg = ptr;
+    return NULL;
+}
+
+// Test 9: Inline fast path
+void test_inline_fast_path() {
+    printf("Test 9: Inline fast path... ");
+    void* ptr = my_malloc_inline(200);
+    assert(ptr != NULL);
+    memset(ptr, 0x12, 200);
+    
+    // Freed small blocks are reused from the thread cache
+    my_free_inline(ptr);
+    assert(malloc_tcache.count == 1);
+    void* again = my_malloc_inline(300);
+    assert(again == ptr);
+    assert(malloc_tcache.count == 0);
+    
+    // Large and zero-sized requests take the regular path
+    void* large = my_malloc_inline(2 * PAGE_SIZE);
+    assert(large != NULL);
+    memset(large, 0x34, 2 * PAGE_SIZE);
+    my_free_inline(large);
+    assert(malloc_tcache.count == 0);
+    assert(my_malloc_inline(0) == NULL);
+    my_free_inline(NULL);
+    
+    // The cache is bounded and can be flushed back
+    void* ptrs[MALLOC_TCACHE_SIZE + 4];
+    for (int i = 0; i < MALLOC_TCACHE_SIZE + 4; i++) {
+        ptrs[i] = my_malloc_inline(64);
+        assert(ptrs[i] != NULL);
+    }
+    for (int i = 0; i < MALLOC_TCACHE_SIZE + 4; i++) {
+        my_free_inline(ptrs[i]);
+    }
+    assert(malloc_tcache.count == MALLOC_TCACHE_SIZE);
+    my_malloc_thread_flush();
+    assert(malloc_tcache.count == 0);
+    
+    my_free_inline(again);
+    my_malloc_thread_flush();
+    
+    // A thread's cached blocks are returned when it exits
+    void* cached = NULL;
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, cache_and_exit, &cached) == 0);
+    pthread_join(thread, NULL);
+    void* reused = my_malloc(64);
+    assert(reused == cached && "Exiting thread leaked its cached block");
+    my_free(reused);
+    printf("Passed\n");
+}
+
+// Test 10: Cache-line coloring and thread-owned placement
+void test_coloring() {
+    printf("Test 10: Coloring... ");
+    // Colored objects are line aligned and start on different lines of their blocks
+    void* colored[4];
+    for (int i = 0; i < 4; i++) {
+        colored[i] = my_malloc_hint(100, MALLOC_COLORED, 0);
+        assert(colored[i] != NULL);
+        assert((uintptr_t)colored[i] % 64 == 0 && "Colored object not line aligned");
+        memset(colored[i], i, 100);
+    }
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            assert((uintptr_t)colored[i] % 1024 != (uintptr_t)colored[j] % 1024);
+        }
+    }
+    
+    // Colored objects always fit in their block
+    for (int i = 0; i < 20; i++) {
+        char* ptr = my_malloc_hint(1000, MALLOC_COLORED | MALLOC_ZEROED, 0);
+        assert(ptr != NULL && (uintptr_t)ptr % 1024 == 0);
+        assert(ptr[999] == 0);
+        my_free(ptr);
+    }
+    
+    // Thread-owned objects are aligned to a cache line pair
+    void* owned = my_malloc_hint(8, MALLOC_THREAD_OWNED, 0);
+    void* owned_large = my_malloc_hint(3 * PAGE_SIZE, MALLOC_THREAD_OWNED, 0);
+    assert(owned != NULL && owned_large != NULL);
+    assert((uintptr_t)owned % 128 == 0);
+    assert((uintptr_t)owned_large % 128 == 0);
+    memset(owned_large, 0x42, 3 * PAGE_SIZE);
+    
+    // Colored blocks are freed as a whole and reused
+    my_free(colored[0]);
+    void* reused = my_malloc(100);
+    assert(reused != NULL && (uintptr_t)reused / 1024 == (uintptr_t)colored[0] / 1024);
+    
+    // Pointers that are not an object start are ignored, even at a color step
+    my_free((char*)reused + 8);
+    my_free((char*)reused + 64);
+    my_free_inline((char*)reused + 8);
+    my_free_inline((char*)reused + 64);
+    void* other = my_malloc(100);
+    assert(other != NULL && (uintptr_t)other / 1024 != (uintptr_t)reused / 1024);
+    my_free(other);
+    
+    my_free(reused);
+    for (int i = 1; i < 4; i++) my_free(colored[i]);
+    my_free(owned);
+    my_free(owned_large);
+    printf("Passed\n");
+}
+
+// Runs `bad_access` in a guarded child; returns 1 if it died of SIGSEGV
+// after reporting `expected` on stderr
+static int guard_catches(void (*bad_access)(void), const char* expected) {
+    int channel[2];
+    assert(pipe(channel) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        dup2(channel[1], STDERR_FILENO);
+        my_malloc_guard_enable(1);
+        bad_access();
+        _exit(0);
+    }
+    close(channel[1]);
+    char report[4096] = {0};
+    size_t used = 0;
+    ssize_t n;
+    while (used < sizeof(report) - 1 &&
+           (n = read(channel[0], report + used, sizeof(report) - 1 - used)) > 0) {
+        used += n;
+    }
+    close(channel[0]);
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV && strstr(report, expected) != NULL;
+}
+
+static void use_after_free() {
+    char* ptr = my_malloc(100);
+    my_free(ptr);
+    ((volatile char*)ptr)[0] = 1;
+}
+
+static void overflow() {
+    char* ptr = my_malloc(64);
+    ((volatile char*)ptr)[64] = 1;
+}
+
+static void* first_allocation(void* arg) {
+    *(void**)arg = my_malloc(100);
+    return NULL;
+}
+
+// Test 11: Sampled guard pages
+void test_guard_pages() {
+    printf("Test 11: Guard pages... ");
+    my_malloc_guard_enable(1);
+    
+    // Sampled objects end on a guard page and behave like normal memory
+    char* small = my_malloc(100);
+    char* page = my_malloc_hint(PAGE_SIZE, MALLOC_ZEROED, 0);
+    assert(small != NULL && page != NULL);
+    assert(((uintptr_t)small + 112) % PAGE_SIZE == 0 && "Not right-aligned");
+    assert((uintptr_t)page % PAGE_SIZE == 0 && page[PAGE_SIZE - 1] == 0);
+    memset(small, 0x21, 100);
+    
+    // Larger requests are never sampled
+    void* large = my_malloc(2 * PAGE_SIZE);
+    assert(large != NULL && ((uintptr_t)large + 112) % PAGE_SIZE != 0);
+    my_free(large);
+    
+    // Neither are requests whose placement hints a slot cannot honour
+    void* owned = my_malloc_hint(100, MALLOC_THREAD_OWNED, 0);
+    void* no_dump = my_malloc_hint(100, MALLOC_NO_DUMP, 0);
+    assert(owned != NULL && (uintptr_t)owned % 128 == 0 && "Thread-owned object sampled");
+    assert(no_dump != NULL && (uintptr_t)no_dump % 1024 == 0 && "No-dump object sampled");
+    my_free(owned);
+    my_free(no_dump);
+    
+    // Frees of sampled objects work, and stale pointers fault with a report
+    my_free(small);
+    my_free(page);
+    assert(guard_catches(use_after_free, "use-after-free"));
+    assert(guard_catches(overflow, "buffer overflow"));
+    
+    // A new thread does not sample its first allocation at a high rate
+    void* first = NULL;
+    pthread_t thread;
+    my_malloc_guard_enable(1u << 30);
+    assert(pthread_create(&thread, NULL, first_allocation, &first) == 0);
+    pthread_join(thread, NULL);
+    assert(first != NULL && (uintptr_t)first % 1024 == 0 && "First allocation sampled");
+    my_free(first);
+    
+    my_malloc_guard_enable(0);
+    void* unsampled = my_malloc(100);
+    assert(unsampled != NULL && (uintptr_t)unsampled % 1024 == 0);
+    my_free(unsampled);
+    printf("Passed\n");
+}
+
 int main() {
     test_basic_small_allocation();
     test_basic_large_allocation();
@@ -161,6 +475,11 @@ int main() {
     test_multiple_large_allocations();
     test_mixed_allocations();
     test_edge_cases();
+    test_allocation_hints();
+    test_reserve();
+    test_inline_fast_path();
+    test_coloring();
+    test_guard_pages();
     
     printf("All allocator tests passed successfully!\n");
     return 0;
@@ -0,0 +1,47 @@
+#include "allocator_inline.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+struct Node {
+    Node* next;
+    char payload[120];
+};
+
+struct Page {
+    char data[8192];
+};
+
+// Test 1: Compile-time size class for a small type
+void test_small_type() {
+    printf("Test 1: Small type... ");
+    Node* node = my_malloc_for<Node>();
+    assert(node != NULL);
+    memset(node, 0x5A, sizeof(Node));
+    my_free_inline(node);
+
+    // The same block comes back from the thread cache
+    Node* again = my_malloc_for<Node>();
+    assert(again == node);
+    my_free_inline(again);
+    printf("Passed\n");
+}
+
+// Test 2: Compile-time size class for a large type
+void test_large_type() {
+    printf("Test 2: Large type... ");
+    Page* page = my_malloc_for<Page>();
+    assert(page != NULL);
+    memset(page, 0xA5, sizeof(Page));
+    my_free_inline(page);
+    printf("Passed\n");
+}
+
+int main() {
+    test_small_type();
+    test_large_type();
+    my_malloc_thread_flush();
+
+    printf("All C++ allocator tests passed successfully!\n");
+    return 0;
+}
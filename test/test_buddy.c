@@ -2,6 +2,11 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 
 // Test 1: Basic allocation and free
 void test_basic_allocation() {
@@ -179,6 +184,307 @@ void test_comprehensive_free() {
     printf("Test 6 (Comprehensive Free) Passed\n");
 }
 
+// Test 7: Small blocks must not overlap larger ones
+void test_no_overlap() {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+    
+    // A live 1KB block leaves no room for a 1MB block
+    void* small_block = buddy_alloc(&buddy, 1024);
+    assert(small_block != NULL);
+    assert(buddy_alloc(&buddy, 1024 * 1024) == NULL);
+    
+    // Growing sizes must land in disjoint ranges
+    void* half = buddy_alloc(&buddy, 512 * 1024);
+    void* quarter = buddy_alloc(&buddy, 256 * 1024);
+    assert(half != NULL && quarter != NULL);
+    assert((uint8_t*)half >= (uint8_t*)small_block + 1024);
+    assert((uint8_t*)quarter >= (uint8_t*)small_block + 1024);
+    assert(half != quarter);
+    
+    // Freeing everything merges back into the whole pool
+    buddy_free(&buddy, small_block);
+    buddy_free(&buddy, half);
+    buddy_free(&buddy, quarter);
+    void* full_block = buddy_alloc(&buddy, 1024 * 1024);
+    assert(full_block == buddy.memory_pool);
+    
+    buddy_free(&buddy, full_block);
+    printf("Test 7 (No Overlap) Passed\n");
+}
+
+// Test 8: Deferred coalescing through the quick lists
+void test_quick_lists() {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+    
+    // A freed block is handed back to the next same-size request
+    void* block = buddy_alloc(&buddy, 4096);
+    assert(block != NULL);
+    buddy_free(&buddy, block);
+    assert(buddy.quick_count[get_level(4096)] == 1);
+    assert(buddy_alloc(&buddy, 4096) == block);
+    assert(buddy.quick_count[get_level(4096)] == 0);
+    
+    // Double free of a cached block is ignored
+    buddy_free(&buddy, block);
+    buddy_free(&buddy, block);
+    assert(buddy.quick_count[get_level(4096)] == 1);
+    
+    // Overflowing the list coalesces the oldest half, the newest stay cached
+    void* blocks[BUDDY_QUICK_LIST_SIZE + 1];
+    for (int i = 0; i <= BUDDY_QUICK_LIST_SIZE; i++) {
+        blocks[i] = buddy_alloc(&buddy, 1024);
+        assert(blocks[i] != NULL);
+    }
+    for (int i = 0; i <= BUDDY_QUICK_LIST_SIZE; i++) {
+        buddy_free(&buddy, blocks[i]);
+    }
+    assert(buddy.quick_count[10] == BUDDY_QUICK_LIST_SIZE / 2 + 1);
+    assert(buddy_alloc(&buddy, 1024) == blocks[BUDDY_QUICK_LIST_SIZE]);
+    assert(buddy_alloc(&buddy, 1024) == blocks[BUDDY_QUICK_LIST_SIZE - 1]);
+    buddy_free(&buddy, blocks[BUDDY_QUICK_LIST_SIZE - 1]);
+    buddy_free(&buddy, blocks[BUDDY_QUICK_LIST_SIZE]);
+    
+    // A larger request flushes the lists and merges back to the whole pool
+    void* full_block = buddy_alloc(&buddy, 1024 * 1024);
+    assert(full_block == buddy.memory_pool);
+    for (int l = 0; l < BUDDY_LEVELS; l++) {
+        assert(buddy.quick_count[l] == 0);
+    }
+    
+    buddy_free(&buddy, full_block);
+    printf("Test 8 (Quick Lists) Passed\n");
+}
+
+// Test 9: File-backed heap survives a detach and reattach
+void test_file_backed() {
+    char path[] = "/tmp/test_buddy_heapXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+    
+    BuddyAllocator buddy;
+    assert(buddy_init_file(&buddy, path) == 0);
+    char* message = buddy_alloc(&buddy, 2048);
+    assert(message != NULL);
+    strcpy(message, "persistent hello");
+    buddy_set_root(&buddy, 0, message);
+    assert(buddy_get_root(&buddy, 0) == message);
+    assert(buddy_get_root(&buddy, 1) == NULL);
+    
+    // The file is locked while attached
+    BuddyAllocator second;
+    assert(buddy_init_file(&second, path) == -1);
+    buddy_close(&buddy);
+    
+    // Reattach: the root and its contents are back, the block is still in use
+    BuddyAllocator again;
+    assert(buddy_init_file(&again, path) == 0);
+    char* restored = buddy_get_root(&again, 0);
+    assert(restored != NULL && strcmp(restored, "persistent hello") == 0);
+    
+    // Out-of-range roots from a damaged file are not followed
+    again.file_header->roots[1] = 1048576 + 1;
+    assert(buddy_get_root(&again, 1) == NULL);
+    again.file_header->roots[1] = 0;
+    assert(buddy_alloc(&again, 1024 * 1024) == NULL);
+    void* other = buddy_alloc(&again, 2048);
+    assert(other != NULL && other != restored);
+    
+    // Freed blocks are released at once and merge back
+    buddy_free(&again, other);
+    buddy_free(&again, restored);
+    buddy_set_root(&again, 0, NULL);
+    void* full_block = buddy_alloc(&again, 1024 * 1024);
+    assert(full_block == again.memory_pool);
+    buddy_free(&again, full_block);
+    buddy_close(&again);
+    
+    // Files with another layout are rejected
+    fd = open(path, O_WRONLY | O_TRUNC);
+    assert(fd != -1);
+    assert(write(fd, "junk", 4) == 4);
+    close(fd);
+    assert(buddy_init_file(&again, path) == -1);
+    
+    // A sized file whose header was never written is a new heap
+    assert(truncate(path, 0) == 0 && truncate(path, 2 * 4096 + 1024 * 1024) == 0);
+    assert(buddy_init_file(&again, path) == 0);
+    assert(buddy_get_root(&again, 0) == NULL);
+    assert(buddy_alloc(&again, 1024 * 1024) == again.memory_pool);
+    buddy_close(&again);
+    
+    unlink(path);
+    printf("Test 9 (File Backed) Passed\n");
+}
+
+// Test 10: Reattaching after a crash repairs the node map
+void test_file_recovery() {
+    char path[] = "/tmp/test_buddy_heapXXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    close(fd);
+    
+    BuddyAllocator buddy;
+    assert(buddy_init_file(&buddy, path) == 0);
+    char* kept = buddy_alloc(&buddy, 1024);
+    assert(kept != NULL);
+    strcpy(kept, "survivor");
+    buddy_set_root(&buddy, 3, kept);
+    
+    // Crash with a stale allocation below a free block and a stale full mark
+    uint32_t level;
+    uint32_t right_half = 2;
+    nodemap_set(&buddy.nodes, 2 * right_half + 1, NODE_ALLOC);
+    nodemap_set(&buddy.nodes, 1, NODE_FULL);
+    assert(find_block_index(&buddy, (uint8_t*)kept - buddy.memory_pool, &level) != -1);
+    munmap(buddy.file_header, 2 * 4096 + 1024 * 1024);
+    close(buddy.file_fd);
+    
+    BuddyAllocator again;
+    assert(buddy_init_file(&again, path) == 0);
+    char* restored = buddy_get_root(&again, 3);
+    assert(strcmp(restored, "survivor") == 0);
+    
+    // The live block is kept, everything else is usable again
+    void* half = buddy_alloc(&again, 512 * 1024);
+    assert(half == again.memory_pool + 512 * 1024);
+    void* quarter = buddy_alloc(&again, 256 * 1024);
+    assert(quarter == again.memory_pool + 256 * 1024);
+    buddy_free(&again, half);
+    buddy_free(&again, quarter);
+    buddy_free(&again, restored);
+    assert(buddy_alloc(&again, 1024 * 1024) == again.memory_pool);
+    buddy_close(&again);
+    
+    unlink(path);
+    printf("Test 10 (File Recovery) Passed\n");
+}
+
+// Test 11: Zero-copy hand-off between processes through a shared heap
+void test_shared_heap() {
+    BuddyAllocator buddy;
+    int fd = buddy_create_shared(&buddy);
+    assert(fd != -1);
+    
+    int channel[2];
+    assert(pipe(channel) == 0);
+    pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        // Child: attach on its own mapping, fill a buffer, send its offset
+        BuddyAllocator child;
+        if (buddy_attach_shared(&child, fd) != 0) _exit(1);
+        char* buffer = buddy_alloc(&child, 8192);
+        if (buffer == NULL) _exit(2);
+        strcpy(buffer, "from the child");
+        uint32_t offset = buddy_to_offset(&child, buffer);
+        if (write(channel[1], &offset, sizeof(offset)) != sizeof(offset)) _exit(3);
+        buddy_detach_shared(&child);
+        _exit(0);
+    }
+    
+    uint32_t offset;
+    assert(read(channel[0], &offset, sizeof(offset)) == sizeof(offset));
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    
+    // The parent sees the child's allocation and data, and can free it
+    char* buffer = buddy_from_offset(&buddy, offset);
+    assert(strcmp(buffer, "from the child") == 0);
+    assert(buddy_alloc(&buddy, 1024 * 1024) == NULL);
+    buddy_free(&buddy, buffer);
+    void* full_block = buddy_alloc(&buddy, 1024 * 1024);
+    assert(full_block == buddy.memory_pool);
+    buddy_free(&buddy, full_block);
+    
+    // A process dying with the lock held does not wedge the heap
+    pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        pthread_mutex_lock(&buddy.shared_header->lock);
+        nodemap_set(&buddy.nodes, 0, NODE_FULL);  // Half-done update
+        _exit(0);
+    }
+    assert(waitpid(pid, &status, 0) == pid);
+    void* after_crash = buddy_alloc(&buddy, 1024);
+    assert(after_crash == buddy.memory_pool);
+    buddy_free(&buddy, after_crash);
+    
+    // Non-heap descriptors are rejected
+    BuddyAllocator other;
+    assert(buddy_attach_shared(&other, channel[0]) == -1);
+    
+    close(channel[0]);
+    close(channel[1]);
+    buddy_detach_shared(&buddy);
+    close(fd);
+    printf("Test 11 (Shared Heap) Passed\n");
+}
+
+// Test 12: Block selection policies
+void test_policies() {
+    BuddyAllocator buddy;
+    buddy_init(&buddy);
+    uint8_t* pool = buddy.memory_pool;
+    
+    // Free 4KB at offset 0 (buddy allocated) and free 1KB at offset 8KB
+    void* a = buddy_alloc(&buddy, 4096);
+    void* b = buddy_alloc(&buddy, 4096);
+    void* c = buddy_alloc(&buddy, 1024);
+    void* d = buddy_alloc(&buddy, 1024);
+    assert(a == pool && b == pool + 4096 && c == pool + 8192 && d == pool + 9216);
+    buddy_free(&buddy, a);
+    buddy_free(&buddy, c);
+    buddy_flush(&buddy);
+    
+    // Smallest sufficient block vs lowest address
+    void* smallest = buddy_alloc(&buddy, 1024);
+    assert(smallest == pool + 8192);
+    buddy_free(&buddy, smallest);
+    buddy_flush(&buddy);
+    buddy_set_policy(&buddy, BUDDY_POLICY_ADDRESS);
+    void* lowest = buddy_alloc(&buddy, 1024);
+    assert(lowest == pool);
+    buddy_free(&buddy, lowest);
+    buddy_free(&buddy, b);
+    buddy_free(&buddy, d);
+    buddy_flush(&buddy);
+    
+    // Free 2KB at 2KB (buddy split) and free 2KB at 4KB (buddy allocated)
+    buddy_set_policy(&buddy, BUDDY_POLICY_SMALLEST);
+    void* x1 = buddy_alloc(&buddy, 1024);
+    void* x2 = buddy_alloc(&buddy, 1024);
+    void* x3 = buddy_alloc(&buddy, 2048);
+    void* x4 = buddy_alloc(&buddy, 2048);
+    void* x5 = buddy_alloc(&buddy, 2048);
+    assert(x3 == pool + 2048 && x4 == pool + 4096 && x5 == pool + 6144);
+    buddy_free(&buddy, x2);
+    buddy_free(&buddy, x3);
+    buddy_free(&buddy, x4);
+    buddy_flush(&buddy);
+    
+    void* first = buddy_alloc(&buddy, 2048);
+    assert(first == pool + 2048);
+    buddy_free(&buddy, first);
+    buddy_flush(&buddy);
+    buddy_set_policy(&buddy, BUDDY_POLICY_BEST_FIT);
+    void* best = buddy_alloc(&buddy, 2048);
+    assert(best == pool + 4096);
+    
+    // Unknown policies are ignored
+    buddy_set_policy(&buddy, 42);
+    assert(buddy.policy == BUDDY_POLICY_BEST_FIT);
+    
+    buddy_free(&buddy, best);
+    buddy_free(&buddy, x1);
+    buddy_free(&buddy, x5);
+    buddy_flush(&buddy);
+    assert(buddy_alloc(&buddy, 1024 * 1024) == pool);
+    printf("Test 12 (Policies) Passed\n");
+}
+
 int main() {
     test_basic_allocation();
     test_multiple_allocations();
@@ -186,6 +492,12 @@ int main() {
     test_full_allocation();
     test_edge_cases();
     test_comprehensive_free();
+    test_no_overlap();
+    test_quick_lists();
+    test_file_backed();
+    test_file_recovery();
+    test_shared_heap();
+    test_policies();
     
     printf("All tests passed successfully!\n");
     return 0;
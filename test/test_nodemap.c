@@ -0,0 +1,107 @@
+#include "nodemap.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Test NodeMap_getBytes calculations
+void test_nodemap_getbytes() {
+    assert(NodeMap_getBytes(0) == 0);    // Edge case: empty tree
+    assert(NodeMap_getBytes(1) == 1);    // 2 slots → 1 byte
+    assert(NodeMap_getBytes(3) == 2);    // 8 slots → 2 bytes
+    assert(NodeMap_getBytes(8) == 64);   // Top block → 1 cache line
+    assert(NodeMap_getBytes(11) == 576); // 256 + 256 * 8 slots
+    printf("test_nodemap_getbytes passed!\n");
+}
+
+// Test nodemap_init initializes struct correctly
+void test_nodemap_init() {
+    uint8_t buffer[576];
+    NodeMap nm;
+    nodemap_init(&nm, buffer, 11);
+
+    assert(nm.buffer == buffer);
+    assert(nm.buffer_size == 576);
+    assert(nm.num_levels == 11);
+    assert(nm.num_nodes == 2047);
+    printf("test_nodemap_init passed!\n");
+}
+
+// Test setting and reading back node states
+void test_node_operations() {
+    uint8_t buffer[2] = {0};
+    NodeMap nm;
+    nodemap_init(&nm, buffer, 3);  // 7 nodes
+
+    nodemap_set(&nm, 1, NODE_SPLIT);
+    assert(nodemap_get(&nm, 1) == NODE_SPLIT);
+    assert(buffer[0] == 0x04);  // Slot 1 → bits 2-3
+
+    nodemap_set(&nm, 1, NODE_ALLOC);
+    assert(nodemap_get(&nm, 1) == NODE_ALLOC);
+    nodemap_set(&nm, 1, NODE_FREE);
+    assert(nodemap_get(&nm, 1) == NODE_FREE);
+    assert(buffer[0] == 0x00);
+
+    // Ensure neighbours are unaffected
+    nodemap_set(&nm, 4, NODE_FULL);
+    assert(nodemap_get(&nm, 3) == NODE_FREE);
+    assert(nodemap_get(&nm, 4) == NODE_FULL);
+    assert(nodemap_get(&nm, 5) == NODE_FREE);
+
+    printf("test_node_operations passed!\n");
+}
+
+// Test that every node has its own slot
+void test_all_nodes() {
+    uint8_t buffer[576] = {0};
+    NodeMap nm;
+    nodemap_init(&nm, buffer, 11);
+
+    for (uint32_t i = 0; i < nm.num_nodes; i++) {
+        nodemap_set(&nm, i, (i % 3) + 1);
+    }
+    for (uint32_t i = 0; i < nm.num_nodes; i++) {
+        assert(nodemap_get(&nm, i) == (i % 3) + 1);
+    }
+    printf("test_all_nodes passed!\n");
+}
+
+// Test the blocked layout keeps bottom subtrees together
+void test_blocked_layout() {
+    uint8_t buffer[576] = {0};
+    NodeMap nm;
+    nodemap_init(&nm, buffer, 11);
+
+    // Node 255 is the first level-8 node: its subtree starts at slot 256
+    nodemap_set(&nm, 255, NODE_ALLOC);
+    assert(buffer[64] == 0x03);
+
+    // Its leftmost leaf (level 10, local slot 3) sits in the same byte
+    nodemap_set(&nm, 1023, NODE_ALLOC);
+    assert(buffer[64] == 0xC3);
+
+    // The last leaf is the last used slot of the last subtree
+    memset(buffer, 0, sizeof(buffer));
+    nodemap_set(&nm, 2046, NODE_ALLOC);
+    assert(buffer[575] == 0x30);
+
+    // nodemap_byte reports the same bytes, and a root-to-leaf path spans 2 lines
+    assert(nodemap_byte(&nm, 255) == 64 && nodemap_byte(&nm, 1023) == 64);
+    assert(nodemap_byte(&nm, 2046) == 575);
+    for (uint32_t index = 2046; index > 0; index = (index - 1) / 2) {
+        assert(nodemap_byte(&nm, index) / 64 == (index < 255 ? 0 : 575 / 64));
+    }
+
+    printf("test_blocked_layout passed!\n");
+}
+
+int main() {
+    test_nodemap_getbytes();
+    test_nodemap_init();
+    test_node_operations();
+    test_all_nodes();
+    test_blocked_layout();
+
+    printf("All nodemap tests passed!\n");
+    return 0;
+}